@@ -3,8 +3,18 @@
 #include "Vec2.h"
 #include "Range.h"
 #include "LinkedListNode.h"
+#include "CollisionElement.h"
 #include "QuadTree.h"
+#include "LinearQuadTree.h"
+#include "SpatialHash.h"
+#include "SortAndSweep.h"
+#include "PairCache.h"
+#include "ThreadPool.h"
+#include "RectMerge.h"
+#include "BitGrid.h"
 #include "Ray.h"
+#include "CollisionFilter.h"
+#include "Pool.h"
 
 namespace math
 {
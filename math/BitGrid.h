@@ -0,0 +1,116 @@
+#pragma once
+#include <cmath>
+#include <vector>
+#include "Core.h"
+#include "Vec2.h"
+
+namespace math
+{
+	// One bit for each cell of a uniform grid over a rectangle. Each row is packed into 64-bit words, so testing a point is a single bit lookup and testing a rect is a couple of masked word tests per row.
+	class BitGrid
+	{
+	public:
+		BitGrid() :
+			m_Origin(0.f, 0.f),
+			m_CellDim(1.f, 1.f),
+			m_Width(0),
+			m_Height(0),
+			m_Stride(0)
+		{}
+		BitGrid(const Vec2<float>& origin, const Vec2<float>& cellDim, uint width, uint height) :
+			m_Origin(origin),
+			m_CellDim(cellDim),
+			m_Width(width),
+			m_Height(height),
+			m_Stride((width + 63) / 64),
+			m_Bits(CAST(size_t, m_Stride) * height, 0)
+		{}
+
+
+		void Set(uint x, uint y)
+		{
+			m_Bits[CAST(size_t, y) * m_Stride + x / 64] |= 1ull << (x % 64);
+		}
+		// sets every cell whose center is inside the given rect, which is exactly the cells it covers if it's lined up with the grid
+		void SetRect(const Vec2<float>& pos, const Vec2<float>& dim)
+		{
+			// the center of cell i is at i + .5
+			const Vec2<float> lo = (pos - m_Origin) / m_CellDim, hi = (pos + dim - m_Origin) / m_CellDim;
+			const int x0 = CAST(int, max(std::floor(lo.x + .5f), 0.f)), y0 = CAST(int, max(std::floor(lo.y + .5f), 0.f));
+			const int x1 = CAST(int, min(std::ceil(hi.x - .5f) - 1.f, m_Width - 1.f)), y1 = CAST(int, min(std::ceil(hi.y - .5f) - 1.f, m_Height - 1.f));
+			for (int y = y0; y <= y1; y++)
+				for (int x = x0; x <= x1; x++)
+					Set(x, y);
+		}
+		bool Test(uint x, uint y) const
+		{
+			return (m_Bits[CAST(size_t, y) * m_Stride + x / 64] >> (x % 64)) & 1;
+		}
+		// whether the cell containing pos is set. Everything outside of the grid is clear.
+		bool TestPoint(const Vec2<float>& pos) const
+		{
+			const float fx = std::floor((pos.x - m_Origin.x) / m_CellDim.x), fy = std::floor((pos.y - m_Origin.y) / m_CellDim.y);
+			if (fx < 0.f || fy < 0.f || fx >= m_Width || fy >= m_Height)
+				return false;
+			return Test(CAST(uint, fx), CAST(uint, fy));
+		}
+		// whether any cell that the given rect overlaps is set. Only touching a cell's edge doesn't count.
+		bool TestRect(const Vec2<float>& pos, const Vec2<float>& dim) const
+		{
+			int x0, y0, x1, y1;
+			if (!GetCells(pos, dim, &x0, &y0, &x1, &y1))
+				return false;
+
+			// the same mask applies to every row
+			const uint w0 = x0 / 64, w1 = x1 / 64;
+			const ulong first = ~0ull << (x0 % 64), last = ~0ull >> (63 - x1 % 64);
+			for (int y = y0; y <= y1; y++)
+			{
+				const ulong* const row = m_Bits.data() + CAST(size_t, y) * m_Stride;
+				if (w0 == w1)
+				{
+					if (row[w0] & first & last)
+						return true;
+					continue;
+				}
+				if ((row[w0] & first) || (row[w1] & last))
+					return true;
+				for (uint w = w0 + 1; w < w1; w++)
+					if (row[w])
+						return true;
+			}
+			return false;
+		}
+		const Vec2<float>& GetCellDim() const
+		{
+			return m_CellDim;
+		}
+	private:
+		Vec2<float> m_Origin, m_CellDim;
+		uint m_Width, m_Height, m_Stride;
+		// m_Stride words per row
+		std::vector<ulong> m_Bits;
+
+
+		// Range of cells that the given rect overlaps (more than just an edge of), clamped to the grid. Returns false if that's empty.
+		bool GetCells(const Vec2<float>& pos, const Vec2<float>& dim, int* const x0, int* const y0, int* const x1, int* const y1) const
+		{
+			// an empty grid (like a default one) has nothing to clamp to
+			if (m_Width == 0 || m_Height == 0)
+				return false;
+
+			const Vec2<float> lo = (pos - m_Origin) / m_CellDim, hi = (pos + dim - m_Origin) / m_CellDim;
+			// a rect with no width still overlaps the cell it's in
+			const float fx0 = std::floor(lo.x), fy0 = std::floor(lo.y);
+			const float fx1 = max(fx0, std::ceil(hi.x) - 1.f), fy1 = max(fy0, std::ceil(hi.y) - 1.f);
+			if (fx1 < 0.f || fy1 < 0.f || fx0 >= m_Width || fy0 >= m_Height || hi.x < lo.x || hi.y < lo.y)
+				return false;
+
+			*x0 = CAST(int, max(fx0, 0.f));
+			*y0 = CAST(int, max(fy0, 0.f));
+			*x1 = CAST(int, min(fx1, m_Width - 1.f));
+			*y1 = CAST(int, min(fy1, m_Height - 1.f));
+			return *x0 <= *x1 && *y0 <= *y1;
+		}
+	};
+}
@@ -0,0 +1,220 @@
+#pragma once
+#include <type_traits>
+#include <vector>
+#include "Core.h"
+#include "Vec2.h"
+#include "SmallVector.h"
+#include "StaticGrid.h"
+#include "CollisionFilter.h"
+
+namespace math
+{
+	/**
+	 * CollisionElement.h
+	 */
+
+	// Everything about an Element that doesn't depend on which broadphase it's stored in: its bounds, velocity, and CollisionFilter, and how it checks and resolves collisions once it's been given something to check. QuadTreeElement, LinearQuadTreeElement, and SpatialHashElement derive from this as ELEMENT and only add their storage, Move, and Update(delta). ELEMENT has to have a GetStatics() that returns the Elements from its broadphase's SetStatics, or nullptr. See QuadTreeElement for DERIVED.
+	template<typename ELEMENT, typename DERIVED>
+	class CollisionElement
+	{
+	protected:
+		typedef CollisionElement<ELEMENT, DERIVED> Collider;
+
+
+	public:
+		struct CollisionInfo
+		{
+			ELEMENT* element;
+			Vec2<float> normal, contact;
+			float time;
+		};
+
+
+		CollisionElement(const math::Vec2<float>& pos, const math::Vec2<float>& dim, const math::Vec2<float>& vel) :
+			m_Pos(pos),
+			m_Dim(dim),
+			m_Vel(vel),
+			m_Filter()
+		{}
+		CollisionElement(const Collider& other) = delete;
+		CollisionElement(Collider&& other) noexcept :
+			m_Pos(other.m_Pos),
+			m_Dim(other.m_Dim),
+			m_Vel(other.m_Vel),
+			m_Filter(other.m_Filter)
+		{}
+		virtual ~CollisionElement() {}
+
+
+		virtual void ResolveCollision(const CollisionInfo& info) = 0;
+		// Same as Update(delta), but collisions with other dynamic Elements have already been found by the caller (see PairCache). They skip detection and are only checked again right before being resolved. Elements from SetStatics are still checked.
+		void Update(float delta, const CollisionInfo* const contacts, uint count);
+		// Update(delta, contacts, count) in two halves, so that detection can run ahead of time (and on any thread, since it doesn't modify anything). FindCollisions appends the collisions to resolve to out, in the order they'd be resolved, and returns how many there are. Passing those to ResolveCollisions gives the same result as Update would have, as long as nothing has moved this or changed its velocity in between (resolving another Element can stop this one).
+		uint FindCollisions(float delta, const CollisionInfo* const contacts, uint count, std::vector<CollisionInfo>* const out) const;
+		void ResolveCollisions(float delta, CollisionInfo* const collisions, uint count);
+		// runs our narrowphase against other, for when collisions are detected outside of Update
+		bool Detect(ELEMENT* const other, float delta, CollisionInfo* const info) const
+		{
+			info->element = other;
+			return CallIntersects(other, delta, &info->normal, &info->contact, &info->time);
+		}
+		const math::Vec2<float>& GetPos() const
+		{
+			return m_Pos;
+		}
+		const math::Vec2<float>& GetVel() const
+		{
+			return m_Vel;
+		}
+		const math::Vec2<float>& GetDim() const
+		{
+			return m_Dim;
+		}
+		const void SetPos(const math::Vec2<float>& pos)
+		{
+			m_Pos = pos;
+		}
+		const void SetVel(const math::Vec2<float>& vel)
+		{
+			m_Vel = vel;
+		}
+		const CollisionFilter& GetFilter() const
+		{
+			return m_Filter;
+		}
+		void SetFilter(const CollisionFilter& filter)
+		{
+			m_Filter = filter;
+		}
+	protected:
+		constexpr static uint s_InlineCollisions = 16;
+		// position, size, and velocity of the "host" object
+		Vec2<float> m_Pos, m_Dim, m_Vel;
+		CollisionFilter m_Filter;
+
+
+		virtual bool Intersects(const ELEMENT* const other, float delta, Vec2<float>* const normal, Vec2<float>* const contact, float* const time) const = 0;
+		// Intersects and ResolveCollision, called on DERIVED directly if there is one so that they can be inlined. Everything else calls these instead.
+		bool CallIntersects(const ELEMENT* const other, float delta, Vec2<float>* const normal, Vec2<float>* const contact, float* const time) const
+		{
+			if constexpr (std::is_void_v<DERIVED>)
+				return Intersects(other, delta, normal, contact, time);
+			else
+				return CAST(const DERIVED*, this)->DERIVED::Intersects(other, delta, normal, contact, time);
+		}
+		void CallResolveCollision(const CollisionInfo& info)
+		{
+			if constexpr (std::is_void_v<DERIVED>)
+				ResolveCollision(info);
+			else
+				CAST(DERIVED*, this)->DERIVED::ResolveCollision(info);
+		}
+		// marks and resolves collisions with everything gather(mark, insert) passes to mark, plus any statics we overlap. Collisions passed to insert are already known to exist.
+		template<typename FN>
+		void Collide(float delta, const FN& gather);
+		// runs gather and checks Elements from SetStatics, passing everything we collide with to insert
+		template<typename FN, typename INSERT>
+		void Gather(float delta, const FN& gather, const INSERT& insert) const;
+		void CopyHostValues(const Vec2<float>& pos, const Vec2<float>& dim, const Vec2<float>& vel)
+		{
+			m_Pos = pos;
+			m_Dim = dim;
+			m_Vel = vel;
+		}
+	};
+
+
+	/**
+	 * CollisionElement.cpp
+	 */
+	template<typename ELEMENT, typename DERIVED>
+	template<typename FN, typename INSERT>
+	void CollisionElement<ELEMENT, DERIVED>::Gather(float delta, const FN& gather, const INSERT& insert) const
+	{
+		// to store info about collisions
+		math::Vec2<float> normal = { 0.f, 0.f }, contact = { 0.f, 0.f };
+		float time = 0.f;
+
+		const auto mark = [&](ELEMENT* const cur)
+		{
+			// mark it as a collision if there's an intersection
+			if (CallIntersects(cur, delta, &normal, &contact, &time))
+				insert({ cur, normal, contact, time });
+		};
+
+		// pairs that our filters rule out never get to the narrowphase
+		gather([&](ELEMENT* const cur) { if (m_Filter.Accepts(cur->GetFilter())) mark(cur); }, insert);
+
+		// Elements that aren't stored in the broadphase. Anything we could have passed through since the last step counts too.
+		if (const StaticGrid<ELEMENT>* const statics = CAST(const ELEMENT*, this)->GetStatics())
+			statics->QuerySwept(m_Pos, m_Dim, m_Vel * -delta, m_Filter, mark);
+	}
+	template<typename ELEMENT, typename DERIVED>
+	template<typename FN>
+	void CollisionElement<ELEMENT, DERIVED>::Collide(float delta, const FN& gather)
+	{
+		// we aren't moving, so we can't cause any collisions
+		if (m_Vel == 0.f)
+			return;
+
+		// sorted by time. It's not uncommon for multiple collisions to have the same "time" and regardless of that they all need to get resolved, so equal times stay in the order they were found.
+		SmallVector<CollisionInfo, s_InlineCollisions> collisions;
+		const auto insert = [&](const CollisionInfo& info)
+		{
+			uint index = collisions.GetSize();
+			while (index > 0 && collisions[index - 1].time > info.time)
+				index--;
+			collisions.Insert(index, info);
+		};
+		Gather(delta, gather, insert);
+		ResolveCollisions(delta, collisions.begin(), collisions.GetSize());
+	}
+	template<typename ELEMENT, typename DERIVED>
+	void CollisionElement<ELEMENT, DERIVED>::Update(float delta, const CollisionInfo* const contacts, uint count)
+	{
+		Collide(delta, [contacts, count](const auto&, const auto& insert)
+			{
+				for (uint i = 0; i < count; i++)
+					insert(contacts[i]);
+			});
+	}
+	template<typename ELEMENT, typename DERIVED>
+	uint CollisionElement<ELEMENT, DERIVED>::FindCollisions(float delta, const CollisionInfo* const contacts, uint count, std::vector<CollisionInfo>* const out) const
+	{
+		// we aren't moving, so we can't cause any collisions. Nothing resolved before us can speed us back up, so this still holds in ResolveCollisions
+		if (m_Vel == 0.f)
+			return 0;
+
+		// same order as Collide would resolve them in
+		const uint start = CAST(uint, out->size());
+		const auto insert = [&](const CollisionInfo& info)
+		{
+			uint index = CAST(uint, out->size());
+			while (index > start && (*out)[index - 1].time > info.time)
+				index--;
+			out->insert(out->begin() + index, info);
+		};
+		Gather(delta, [contacts, count](const auto&, const auto& insert)
+			{
+				for (uint i = 0; i < count; i++)
+					insert(contacts[i]);
+			}, insert);
+		return CAST(uint, out->size()) - start;
+	}
+	template<typename ELEMENT, typename DERIVED>
+	void CollisionElement<ELEMENT, DERIVED>::ResolveCollisions(float delta, CollisionInfo* const collisions, uint count)
+	{
+		// an earlier collision this frame may have stopped us
+		if (m_Vel == 0.f)
+			return;
+
+		// for all marked collisions
+		for (uint i = 0; i < count; i++)
+		{
+			CollisionInfo& c = collisions[i];
+			// make sure this collision still exists before resolving it
+			if (CallIntersects(c.element, delta, &c.normal, &c.contact, &c.time))
+				CallResolveCollision(c);
+		}
+	}
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include "Core.h"
+
+namespace math
+{
+	// Which Elements are allowed to collide. Two of them only do if each one's category shares a bit with the other's mask, so filtering is always symmetric. By default everything is in category 1 and collides with everything.
+	struct CollisionFilter
+	{
+		uint category = 1, mask = ~0u;
+
+
+		bool Accepts(const CollisionFilter& other) const
+		{
+			return (category & other.mask) && (other.category & mask);
+		}
+	};
+}
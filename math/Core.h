@@ -186,6 +186,13 @@ namespace math
 	{
 		return CAST(A, CAST(double, std::rand()) / CAST(double, RAND_MAX) * (max - min) + min);
 	}
+	// 64-bit FNV-1a. Pass the result back in as hash to keep going with more data.
+	constexpr static ulong fnv1a(const char* data, size_t size, ulong hash = 0xcbf29ce484222325ull)
+	{
+		for (size_t i = 0; i < size; i++)
+			hash = (hash ^ CAST(uchar, data[i])) * 0x100000001b3ull;
+		return hash;
+	}
 	static void sleep(uint ms)
 	{
 		std::this_thread::sleep_for(std::chrono::milliseconds(ms));
@@ -0,0 +1,432 @@
+#pragma once
+#include <type_traits>
+#include <vector>
+#include "Core.h"
+#include "Vec2.h"
+#include "SmallVector.h"
+#include "StaticGrid.h"
+#include "Ray.h"
+#include "CollisionElement.h"
+
+namespace math
+{
+	/**
+	 * LinearQuadTree.h
+	 */
+
+	// see QuadTreeElement for DERIVED
+	template<uint THRESHOLD, typename DERIVED = void>
+	class LinearQuadTreeElement;
+
+	// Drop-in alternative to QuadTreeNode with no Node objects at all. It's a complete quad tree whose leaves live in one array, ordered by Morton code so that leaves that are close in space are close in memory. Each leaf is a range into one packed array of Elements. Instead of moving Elements around the tree one at a time, Move just marks the tree as out of date, and the next Update or query rebuilds the whole thing in a few linear passes.
+	template<uint THRESHOLD, typename DERIVED = void>
+	class LinearQuadTree
+	{
+	public:
+		typedef LinearQuadTree<THRESHOLD, DERIVED> Node;
+		typedef LinearQuadTreeElement<THRESHOLD, DERIVED> Element;
+		typedef StaticGrid<Element> Statics;
+		friend class LinearQuadTreeElement<THRESHOLD, DERIVED>;
+
+
+		struct Stats
+		{
+			// depth and number of leaves as of the last rebuild
+			uint depth, leaves;
+			// number of Elements, total number of leaf entries they take up, and number of times the tree has been rebuilt
+			uint elements, entries, rebuilds;
+		};
+
+
+		LinearQuadTree(const math::Vec2<float>& min, const math::Vec2<float>& max);
+		LinearQuadTree(const Node& other) = delete;
+		LinearQuadTree(Node&& other) = delete;
+		~LinearQuadTree();
+
+
+		void Add(Element* e);
+		// see QuadTreeNode::Build. Add is already cheap here, nothing happens until the next rebuild.
+		void Build(Element* const* const elements, uint count)
+		{
+			m_Elements.reserve(m_Elements.size() + count);
+			for (uint i = 0; i < count; i++)
+				Add(elements[i]);
+		}
+		void Remove(Element* e);
+		// see QuadTreeNode::SetDeferredMerges/EndFrame. Nothing to do, changes are already batched up until the next rebuild.
+		void SetDeferredMerges(bool deferred) {}
+		void EndFrame() {}
+		// see QuadTreeNode::SetStatics
+		void SetStatics(const Statics* const statics)
+		{
+			m_Statics = statics;
+		}
+		// Same as the QuadTreeNode queries. They use Element positions as of the last rebuild.
+		uint QueryAABB(const math::Vec2<float>& pos, const math::Vec2<float>& dim, Element** const out, uint capacity) const;
+		uint QueryPoint(const math::Vec2<float>& point, Element** const out, uint capacity) const;
+		uint QueryRay(const math::Ray<float>& ray, Element** const out, float* const times, uint capacity) const;
+		const math::Vec2<float>& GetPos() const
+		{
+			return m_Pos;
+		}
+		uint GetDim() const
+		{
+			return m_Dim;
+		}
+		Stats GetStats() const
+		{
+			return { m_Depth, m_Side * m_Side, CAST(uint, m_Elements.size()), CAST(uint, m_Items.size()), m_Rebuilds };
+		}
+	private:
+		struct Bounds
+		{
+			float minx, miny, maxx, maxy;
+		};
+
+
+		// deepest the tree can go, which keeps the leaf array at 64k entries or less. Leaves are never smaller than s_MinDim on a side.
+		constexpr static uint s_MaxDepth = 8, s_MinDim = 2;
+		// (x, y) of bottom left corner
+		math::Vec2<float> m_Pos;
+		// side length
+		uint m_Dim;
+		// every Element in the tree, and where each one was as of the last rebuild
+		std::vector<Element*> m_Elements;
+		mutable std::vector<Bounds> m_Bounds;
+		// Everything below is rebuilt from m_Elements whenever it's out of date. m_LeafStart[m] to m_LeafStart[m + 1] is the range of m_Items that belongs to the leaf with Morton code m, and m_Items holds indices into m_Elements. An Element is in every leaf it touches.
+		mutable std::vector<uint> m_LeafStart, m_Items, m_Next;
+		// bounds of each entry in m_Items, so that a leaf can be scanned without touching the Elements themselves
+		mutable std::vector<Bounds> m_ItemBounds;
+		// number of levels below the root, number of leaves per side, side length of a leaf
+		mutable uint m_Depth, m_Side;
+		mutable float m_LeafDim;
+		mutable bool m_Dirty;
+		mutable uint m_Rebuilds;
+		const Statics* m_Statics;
+
+
+		// rebuild if anything has changed since last time
+		void Refresh() const
+		{
+			if (m_Dirty)
+				Rebuild();
+		}
+		void Rebuild() const;
+		// calls fn(Element*, const Bounds&) once for each Element whose bounds overlap the given ones
+		template<typename FN>
+		void ForEachOverlapping(const Bounds& q, const FN& fn) const;
+		uint LeafX(float x) const
+		{
+			return CAST(uint, clamp((x - m_Pos.x) / m_LeafDim, 0.f, m_Side - 1.f));
+		}
+		uint LeafY(float y) const
+		{
+			return CAST(uint, clamp((y - m_Pos.y) / m_LeafDim, 0.f, m_Side - 1.f));
+		}
+		// interleave the bits of x and y (x in the even bits)
+		static uint Morton(uint x, uint y)
+		{
+			return Spread(x) | (Spread(y) << 1);
+		}
+		// put a 0 bit in between each of the low 16 bits of v
+		static uint Spread(uint v)
+		{
+			v &= 0x0000ffff;
+			v = (v | (v << 8)) & 0x00ff00ff;
+			v = (v | (v << 4)) & 0x0f0f0f0f;
+			v = (v | (v << 2)) & 0x33333333;
+			v = (v | (v << 1)) & 0x55555555;
+			return v;
+		}
+	};
+
+
+	/**
+	 * LinearQuadTreeElement.h
+	 */
+	template<uint THRESHOLD, typename DERIVED>
+	class LinearQuadTreeElement : public CollisionElement<LinearQuadTreeElement<THRESHOLD, DERIVED>, DERIVED>
+	{
+	protected:
+		typedef LinearQuadTree<THRESHOLD, DERIVED> Node;
+		typedef LinearQuadTreeElement<THRESHOLD, DERIVED> Element;
+		typedef CollisionElement<Element, DERIVED> Collider;
+		friend class LinearQuadTree<THRESHOLD, DERIVED>;
+		friend Collider;
+
+
+	public:
+		LinearQuadTreeElement(const math::Vec2<float>& pos, const math::Vec2<float>& dim, const math::Vec2<float>& vel);
+		LinearQuadTreeElement(const Element& other) = delete;
+		LinearQuadTreeElement(Element&& other) noexcept :
+			Collider(std::move(other)),
+			m_Tree(other.m_Tree),
+			m_Index(other.m_Index)
+		{
+			// the tree refers to us by address
+			if (m_Tree)
+				m_Tree->m_Elements[m_Index] = this;
+			other.m_Tree = nullptr;
+		}
+		virtual ~LinearQuadTreeElement()
+		{
+			// unlike QuadTreeNode, a rebuild touches every Element in the tree, so it can't be left holding on to a dead one
+			Delete();
+		}
+
+
+		using Collider::Update;
+		void Move(const math::Vec2<float>& pos, const math::Vec2<float>& dim, const math::Vec2<float>& vel, Node* const root);
+		void Update(float delta);
+	protected:
+		using Collider::m_Pos;
+		using Collider::m_Dim;
+		using Collider::CopyHostValues;
+		using Collider::Collide;
+		// tree that contains this Element and our index into its list of Elements
+		Node* m_Tree;
+		uint m_Index;
+
+
+		virtual bool IsContainedBy(const Node* const node) const = 0;
+		// IsContainedBy, called on DERIVED directly if there is one (see CollisionElement::CallIntersects)
+		bool CallIsContainedBy(const Node* const node) const
+		{
+			if constexpr (std::is_void_v<DERIVED>)
+				return IsContainedBy(node);
+			else
+				return CAST(const DERIVED*, this)->DERIVED::IsContainedBy(node);
+		}
+		// for CollisionElement::Gather
+		const typename Node::Statics* GetStatics() const
+		{
+			return m_Tree ? m_Tree->m_Statics : nullptr;
+		}
+		void Delete()
+		{
+			if (m_Tree)
+				m_Tree->Remove(this);
+		}
+	};
+
+
+	/**
+	 * LinearQuadTree.cpp
+	 */
+	template<uint THRESHOLD, typename DERIVED>
+	LinearQuadTree<THRESHOLD, DERIVED>::LinearQuadTree(const math::Vec2<float>& min, const math::Vec2<float>& max) :
+		m_Pos(min),
+		m_Dim(0),
+		m_Depth(0),
+		m_Side(1),
+		m_LeafDim(1.f),
+		m_Dirty(true),
+		m_Rebuilds(0),
+		m_Statics(nullptr)
+	{
+		// same sizing as QuadTreeNode, so that leaves always have whole number side lengths
+		const Vec2<float> diff = max - min;
+		m_Dim = nextPower(2, math::max(diff.x, diff.y));
+		m_LeafDim = CAST(float, m_Dim);
+		m_LeafStart.assign(2, 0);
+	}
+	template<uint THRESHOLD, typename DERIVED>
+	LinearQuadTree<THRESHOLD, DERIVED>::~LinearQuadTree()
+	{
+		// Elements can outlive the tree
+		for (Element* e : m_Elements)
+			e->m_Tree = nullptr;
+	}
+	template<uint THRESHOLD, typename DERIVED>
+	void LinearQuadTree<THRESHOLD, DERIVED>::Add(Element* e)
+	{
+		if (e->m_Tree)
+			return;
+
+		if (!e->CallIsContainedBy(this))
+		{
+			const auto& pos = e->m_Pos, dim = e->m_Dim;
+			printf("QuadTree [(%f, %f), (%f, %f)] cannot contain element [(%f, %f), (%f, %f)]\n", m_Pos.x, m_Pos.y, m_Pos.x + m_Dim, m_Pos.y + m_Dim, pos.x, pos.y, pos.x + dim.x, pos.y + dim.y);
+			return;
+		}
+
+		e->m_Tree = this;
+		e->m_Index = CAST(uint, m_Elements.size());
+		m_Elements.push_back(e);
+		m_Dirty = true;
+	}
+	template<uint THRESHOLD, typename DERIVED>
+	void LinearQuadTree<THRESHOLD, DERIVED>::Remove(Element* e)
+	{
+		if (e->m_Tree != this)
+			return;
+
+		// move the last Element into the removed one's place
+		Element* const last = m_Elements.back();
+		m_Elements[e->m_Index] = last;
+		last->m_Index = e->m_Index;
+		m_Elements.pop_back();
+
+		e->m_Tree = nullptr;
+		m_Dirty = true;
+	}
+	template<uint THRESHOLD, typename DERIVED>
+	void LinearQuadTree<THRESHOLD, DERIVED>::Rebuild() const
+	{
+		const uint count = CAST(uint, m_Elements.size());
+
+		// go one level deeper for every factor of 4 Elements, so that leaves hold about THRESHOLD Elements each if they're spread out evenly
+		m_Depth = 0;
+		while (m_Depth < s_MaxDepth && (m_Dim >> (m_Depth + 1)) >= s_MinDim && (1u << (2 * m_Depth)) * THRESHOLD < count)
+			m_Depth++;
+		m_Side = 1u << m_Depth;
+		m_LeafDim = CAST(float, m_Dim >> m_Depth);
+
+		// take a snapshot of where everything is
+		m_Bounds.resize(count);
+		for (uint i = 0; i < count; i++)
+		{
+			const Element* const e = m_Elements[i];
+			m_Bounds[i] = { e->m_Pos.x, e->m_Pos.y, e->m_Pos.x + e->m_Dim.x, e->m_Pos.y + e->m_Dim.y };
+		}
+
+		// counting sort of Elements into leaves. First pass counts the entries in each leaf...
+		const uint leaves = m_Side * m_Side;
+		m_LeafStart.assign(leaves + 1, 0);
+		for (const Bounds& b : m_Bounds)
+			for (uint y = LeafY(b.miny); y <= LeafY(b.maxy); y++)
+				for (uint x = LeafX(b.minx); x <= LeafX(b.maxx); x++)
+					m_LeafStart[Morton(x, y) + 1]++;
+		// ...which turns into a start index for each leaf...
+		for (uint i = 1; i <= leaves; i++)
+			m_LeafStart[i] += m_LeafStart[i - 1];
+		// ...and the second pass fills them in
+		m_Next.assign(m_LeafStart.begin(), m_LeafStart.end() - 1);
+		m_Items.resize(m_LeafStart.back());
+		m_ItemBounds.resize(m_LeafStart.back());
+		for (uint i = 0; i < count; i++)
+		{
+			const Bounds& b = m_Bounds[i];
+			for (uint y = LeafY(b.miny); y <= LeafY(b.maxy); y++)
+			{
+				for (uint x = LeafX(b.minx); x <= LeafX(b.maxx); x++)
+				{
+					const uint slot = m_Next[Morton(x, y)]++;
+					m_Items[slot] = i;
+					m_ItemBounds[slot] = b;
+				}
+			}
+		}
+
+		m_Dirty = false;
+		m_Rebuilds++;
+	}
+	template<uint THRESHOLD, typename DERIVED>
+	template<typename FN>
+	void LinearQuadTree<THRESHOLD, DERIVED>::ForEachOverlapping(const Bounds& q, const FN& fn) const
+	{
+		const uint x0 = LeafX(q.minx), x1 = LeafX(q.maxx), y0 = LeafY(q.miny), y1 = LeafY(q.maxy);
+		for (uint y = y0; y <= y1; y++)
+		{
+			for (uint x = x0; x <= x1; x++)
+			{
+				const uint leaf = Morton(x, y);
+				for (uint i = m_LeafStart[leaf]; i < m_LeafStart[leaf + 1]; i++)
+				{
+					const Bounds& b = m_ItemBounds[i];
+					if (!(q.minx <= b.maxx && b.minx <= q.maxx && q.miny <= b.maxy && b.miny <= q.maxy))
+						continue;
+
+					// same trick as StaticGrid, only report an Element from the leaf that holds the bottom left corner of its overlap with the query
+					if (LeafX(max(q.minx, b.minx)) == x && LeafY(max(q.miny, b.miny)) == y)
+						fn(m_Elements[m_Items[i]], b);
+				}
+			}
+		}
+	}
+	template<uint THRESHOLD, typename DERIVED>
+	uint LinearQuadTree<THRESHOLD, DERIVED>::QueryAABB(const math::Vec2<float>& pos, const math::Vec2<float>& dim, Element** const out, uint capacity) const
+	{
+		Refresh();
+
+		uint count = 0;
+		ForEachOverlapping({ pos.x, pos.y, pos.x + dim.x, pos.y + dim.y }, [&](Element* const e, const Bounds& b)
+			{
+				if (count < capacity)
+					out[count++] = e;
+			});
+		return count + (m_Statics ? m_Statics->QueryAABB(pos, dim, out + count, capacity - count) : 0);
+	}
+	template<uint THRESHOLD, typename DERIVED>
+	uint LinearQuadTree<THRESHOLD, DERIVED>::QueryPoint(const math::Vec2<float>& point, Element** const out, uint capacity) const
+	{
+		return QueryAABB(point, { 0.f, 0.f }, out, capacity);
+	}
+	template<uint THRESHOLD, typename DERIVED>
+	uint LinearQuadTree<THRESHOLD, DERIVED>::QueryRay(const math::Ray<float>& ray, Element** const out, float* const times, uint capacity) const
+	{
+		Refresh();
+
+		// search every leaf touched by the segment's bounding box
+		const Vec2<float> end = ray.origin + ray.direction;
+		const Bounds q = { math::min(ray.origin.x, end.x), math::min(ray.origin.y, end.y), math::max(ray.origin.x, end.x), math::max(ray.origin.y, end.y) };
+
+		// IntersectsRect isn't const
+		math::Ray<float> r = ray;
+		uint count = 0;
+		ForEachOverlapping(q, [&](Element* const e, const Bounds& b)
+			{
+				float time = 0.f;
+				if (count == capacity || !r.IntersectsRect({ b.minx, b.miny }, { b.maxx - b.minx, b.maxy - b.miny }, nullptr, nullptr, &time))
+					return;
+				if (times)
+					times[count] = time;
+				out[count++] = e;
+			});
+		return count + (m_Statics ? m_Statics->QueryRay(ray, out + count, times ? times + count : nullptr, capacity - count) : 0);
+	}
+
+
+
+	/**
+	 * LinearQuadTreeElement.cpp
+	 */
+	template<uint THRESHOLD, typename DERIVED>
+	LinearQuadTreeElement<THRESHOLD, DERIVED>::LinearQuadTreeElement(const math::Vec2<float>& pos, const math::Vec2<float>& dim, const math::Vec2<float>& vel) :
+		Collider(pos, dim, vel),
+		m_Tree(nullptr),
+		m_Index(0)
+	{}
+	template<uint THRESHOLD, typename DERIVED>
+	void LinearQuadTreeElement<THRESHOLD, DERIVED>::Move(const math::Vec2<float>& pos, const math::Vec2<float>& dim, const math::Vec2<float>& vel, Node* const root)
+	{
+		// the tree gets rebuilt from scratch when it's next needed, so all we have to do is tell it that it's out of date
+		if (m_Pos != pos || m_Dim != dim)
+		{
+			CopyHostValues(pos, dim, vel);
+			if (m_Tree)
+				m_Tree->m_Dirty = true;
+			else
+				root->Add(this);
+		}
+		else
+			CopyHostValues(pos, dim, vel);
+	}
+	template<uint THRESHOLD, typename DERIVED>
+	void LinearQuadTreeElement<THRESHOLD, DERIVED>::Update(float delta)
+	{
+		// we aren't in a tree, so there's nothing to check against
+		if (!m_Tree)
+			return;
+
+		Collide(delta, [this](const auto& mark, const auto&)
+			{
+				m_Tree->Refresh();
+				m_Tree->ForEachOverlapping(m_Tree->m_Bounds[m_Index], [&](Element* const cur, const auto& bounds)
+					{
+						if (cur != this)
+							mark(cur);
+					});
+			});
+	}
+}
@@ -0,0 +1,205 @@
+#pragma once
+#include <algorithm>
+#include <vector>
+#include "Core.h"
+#include "Vec2.h"
+#include "SortAndSweep.h"
+
+namespace math
+{
+	// Keeps the pairs from a SortAndSweep across frames. Each Update matches the new pairs against the old ones, so pairs of Elements that are touching can be reported as beginning, persisting, or ending. The contacts for touching pairs are kept too, and reused without running the narrowphase again for as long as neither Element has moved more than `margin` from where it was when it last ran (at either end of its last step, for narrowphases that sweep).
+	// Only touching pairs are reused, because a stale contact just gets rechecked before it's resolved, but a stale miss would never be looked at.
+	template<typename E>
+	class PairCache
+	{
+	public:
+		typedef typename E::CollisionInfo Contact;
+		enum class EventType
+		{
+			BEGIN, PERSIST, END
+		};
+		struct Event
+		{
+			uint a, b;
+			EventType type;
+		};
+		struct Stats
+		{
+			// pairs whose AABBs overlapped in the last Update, and how many of those were actually touching
+			uint pairs, touching;
+			// how many pairs had to run the narrowphase in the last Update, and how many reused their old contacts instead
+			uint narrowphases, reused;
+		};
+
+
+		PairCache(uint capacity, float margin) :
+			m_Margin(margin),
+			m_ContactStart(capacity + 1, 0),
+			m_Narrowphases(0),
+			m_Reused(0)
+		{}
+		PairCache(const PairCache& other) = delete;
+		PairCache(PairCache&& other) = delete;
+
+
+		// Call after sweep.Update(delta). narrowphase(a, b, &ab, &ba) returns true if Elements a and b are touching, and fills in the contact from a's point of view and from b's. It runs at most once per pair, but it's up to it whether that takes one test or one from each side (DynamicList's runs one from each side, so each Hitbox's contact comes from its own swept test).
+		template<typename FN>
+		void Update(const SortAndSweep<E>& sweep, float delta, const FN& narrowphase);
+		// Forget every pair the given id is in, ending the ones that were touching. Has to be called before the id gets reused.
+		void Remove(uint id);
+		// transitions found by the last Update, ordered by pair. ENDs from any Removes before it come first.
+		const std::vector<Event>& GetEvents() const
+		{
+			return m_Events;
+		}
+		// contacts (from the given id's point of view) with everything it was touching as of the last Update
+		const Contact* GetContacts(uint id, uint* const count) const
+		{
+			*count = m_ContactStart[id + 1] - m_ContactStart[id];
+			return m_Contacts.data() + m_ContactStart[id];
+		}
+		Stats GetStats() const
+		{
+			uint touching = 0;
+			for (const Entry& entry : m_Entries)
+				touching += entry.touching;
+			return { CAST(uint, m_Entries.size()), touching, m_Narrowphases, m_Reused };
+		}
+	private:
+		struct Entry
+		{
+			// ids with a < b, packed as (a << 32) | b. Entries are sorted by this.
+			ulong key;
+			bool touching;
+			// bounds of a and b when the narrowphase last ran, and where their steps started
+			Vec2<float> posA, dimA, startA, posB, dimB, startB;
+			// contact from a's point of view and from b's
+			Contact ab, ba;
+		};
+
+
+		float m_Margin;
+		// this frame's and last frame's pairs (swapped each Update)
+		std::vector<Entry> m_Entries, m_Previous;
+		// keys of this frame's pairs, sorted
+		std::vector<ulong> m_Keys;
+		std::vector<Event> m_Events, m_Pending;
+		// m_ContactStart[id] to m_ContactStart[id + 1] is the range of m_Contacts that belongs to id, same layout as StaticGrid
+		std::vector<uint> m_ContactStart, m_ContactNext;
+		std::vector<Contact> m_Contacts;
+		uint m_Narrowphases, m_Reused;
+
+
+		static ulong Key(uint a, uint b)
+		{
+			return a < b ? (CAST(ulong, a) << 32) | b : (CAST(ulong, b) << 32) | a;
+		}
+		// true if e is no longer within the margin of the given bounds
+		bool Moved(const E* const e, float delta, const Vec2<float>& pos, const Vec2<float>& dim, const Vec2<float>& start) const
+		{
+			const Vec2<float>& p = e->GetPos(), & d = e->GetDim(), s = p - e->GetVel() * delta;
+			return abs(p.x - pos.x) > m_Margin || abs(p.y - pos.y) > m_Margin || abs(p.x + d.x - pos.x - dim.x) > m_Margin || abs(p.y + d.y - pos.y - dim.y) > m_Margin ||
+				abs(s.x - start.x) > m_Margin || abs(s.y - start.y) > m_Margin;
+		}
+	};
+
+
+
+	template<typename E>
+	template<typename FN>
+	void PairCache<E>::Update(const SortAndSweep<E>& sweep, float delta, const FN& narrowphase)
+	{
+		m_Events.swap(m_Pending);
+		m_Pending.clear();
+		m_Narrowphases = 0;
+		m_Reused = 0;
+
+		m_Keys.clear();
+		for (const auto& pair : sweep.GetPairs())
+			m_Keys.push_back(Key(pair.a, pair.b));
+		std::sort(m_Keys.begin(), m_Keys.end());
+
+		// both lists are sorted by key, so walk them together
+		m_Previous.swap(m_Entries);
+		m_Entries.clear();
+		uint old = 0;
+		for (const ulong key : m_Keys)
+		{
+			// pairs that aren't overlapping anymore
+			for (; old < m_Previous.size() && m_Previous[old].key < key; old++)
+				if (m_Previous[old].touching)
+					m_Events.push_back({ CAST(uint, m_Previous[old].key >> 32), CAST(uint, m_Previous[old].key), EventType::END });
+
+			const uint a = CAST(uint, key >> 32), b = CAST(uint, key);
+			E* const ea = sweep.GetElement(a), * const eb = sweep.GetElement(b);
+			const bool existed = old < m_Previous.size() && m_Previous[old].key == key;
+			const bool wasTouching = existed && m_Previous[old].touching;
+
+			// reuse the old contacts unless one of them has moved too far since they were found
+			if (wasTouching && !Moved(ea, delta, m_Previous[old].posA, m_Previous[old].dimA, m_Previous[old].startA) && !Moved(eb, delta, m_Previous[old].posB, m_Previous[old].dimB, m_Previous[old].startB))
+			{
+				m_Entries.push_back(m_Previous[old]);
+				m_Reused++;
+			}
+			else
+			{
+				Entry entry = { key, false, ea->GetPos(), ea->GetDim(), ea->GetPos() - ea->GetVel() * delta, eb->GetPos(), eb->GetDim(), eb->GetPos() - eb->GetVel() * delta, {}, {} };
+				entry.touching = narrowphase(ea, eb, &entry.ab, &entry.ba);
+				m_Entries.push_back(entry);
+				m_Narrowphases++;
+			}
+			old += existed;
+
+			const bool touching = m_Entries.back().touching;
+			if (touching || wasTouching)
+				m_Events.push_back({ a, b, !wasTouching ? EventType::BEGIN : (touching ? EventType::PERSIST : EventType::END) });
+		}
+		for (; old < m_Previous.size(); old++)
+			if (m_Previous[old].touching)
+				m_Events.push_back({ CAST(uint, m_Previous[old].key >> 32), CAST(uint, m_Previous[old].key), EventType::END });
+
+		// counting sort of the touching pairs' contacts by id
+		m_ContactStart.assign(m_ContactStart.size(), 0);
+		for (const Entry& entry : m_Entries)
+		{
+			if (entry.touching)
+			{
+				m_ContactStart[(entry.key >> 32) + 1]++;
+				m_ContactStart[CAST(uint, entry.key) + 1]++;
+			}
+		}
+		for (uint i = 1; i < m_ContactStart.size(); i++)
+			m_ContactStart[i] += m_ContactStart[i - 1];
+		m_ContactNext.assign(m_ContactStart.begin(), m_ContactStart.end() - 1);
+		m_Contacts.resize(m_ContactStart.back());
+		for (const Entry& entry : m_Entries)
+		{
+			if (entry.touching)
+			{
+				m_Contacts[m_ContactNext[entry.key >> 32]++] = entry.ab;
+				m_Contacts[m_ContactNext[CAST(uint, entry.key)]++] = entry.ba;
+			}
+		}
+	}
+	template<typename E>
+	void PairCache<E>::Remove(uint id)
+	{
+		for (uint i = 0; i < m_Entries.size();)
+		{
+			const Entry& entry = m_Entries[i];
+			const uint a = CAST(uint, entry.key >> 32), b = CAST(uint, entry.key);
+			if (a == id || b == id)
+			{
+				if (entry.touching)
+					m_Pending.push_back({ a, b, EventType::END });
+				m_Entries.erase(m_Entries.begin() + i);
+			}
+			else
+				i++;
+		}
+
+		// some of our contacts point at this Element until the next Update
+		m_ContactStart.assign(m_ContactStart.size(), 0);
+		m_Contacts.clear();
+	}
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include <new>
+#include <vector>
+#include "Core.h"
+
+namespace math
+{
+	// Fixed-size object allocator. Objects are carved out of slabs of SLAB objects each, and freed objects go onto a free list instead of back to the heap. Once a Pool has grown to its peak size, New and Delete never touch the global heap.
+	template<typename T, uint SLAB = 64>
+	class Pool
+	{
+	public:
+		Pool() :
+			m_Free(nullptr),
+			m_Used(0),
+			m_Peak(0)
+		{}
+		Pool(const Pool& other) = delete;
+		Pool(Pool&& other) = delete;
+		~Pool()
+		{
+			// objects still alive at this point are the owner's problem, we only release the raw storage
+			for (Slot* slab : m_Slabs)
+				delete[] slab;
+		}
+
+
+		template<typename ... Args>
+		T* New(Args&& ... args)
+		{
+			return new (Allocate()) T(std::forward<Args>(args)...);
+		}
+		void Delete(T* const t)
+		{
+			if (!t)
+				return;
+
+			t->~T();
+			Free(t);
+		}
+		// Same as New and Delete, but only the memory. For when something else does the construction, like a class-specific operator new (see Script).
+		void* Allocate()
+		{
+			if (!m_Free)
+				Grow();
+
+			// pop the head of the free list
+			Slot* slot = m_Free;
+			m_Free = slot->next;
+			m_Used++;
+			m_Peak = max(m_Peak, m_Used);
+			return slot->storage;
+		}
+		void Free(void* const t)
+		{
+			if (!t)
+				return;
+
+			// push the slot back onto the free list
+			Slot* slot = reinterpret_cast<Slot*>(t);
+			slot->next = m_Free;
+			m_Free = slot;
+			m_Used--;
+		}
+		// number of objects this Pool can hold without growing
+		uint GetSize() const
+		{
+			return CAST(uint, m_Slabs.size()) * SLAB;
+		}
+		// number of objects currently alive
+		uint GetUsed() const
+		{
+			return m_Used;
+		}
+		// largest number of objects that have been alive at the same time
+		uint GetPeak() const
+		{
+			return m_Peak;
+		}
+	private:
+		union Slot
+		{
+			Slot* next;
+			alignas(T) uchar storage[sizeof(T)];
+		};
+
+
+		Slot* m_Free;
+		std::vector<Slot*> m_Slabs;
+		uint m_Used, m_Peak;
+
+
+		void Grow()
+		{
+			Slot* slab = new Slot[SLAB];
+			// thread the new slots onto the free list
+			for (uint i = 0; i < SLAB - 1; i++)
+				slab[i].next = &slab[i + 1];
+			slab[SLAB - 1].next = m_Free;
+			m_Free = slab;
+			m_Slabs.push_back(slab);
+		}
+	};
+}
@@ -1,12 +1,16 @@
 #pragma once
-#include <unordered_map>
-#include <unordered_set>
-#include <map>
-#include <set>
+#include <algorithm>
+#include <type_traits>
+#include <vector>
 #include "Core.h"
 #include "Range.h"
 #include "Vec2.h"
 #include "LinkedListNode.h"
+#include "Pool.h"
+#include "SmallVector.h"
+#include "StaticGrid.h"
+#include "Ray.h"
+#include "CollisionElement.h"
 
 namespace math
 {
@@ -14,18 +18,47 @@ namespace math
 	 * QuadTreeNode.h
 	 */
 
-	template<uint THRESHOLD>
+	// Every leaf an Element touches stores it, and only leaves store Elements
+	struct QuadTreeStrict
+	{
+		constexpr static bool s_Loose = false;
+		constexpr static float s_Looseness = 0.f;
+	};
+	// Each Node's bounds are grown by half its side length in every direction, and each Element is stored exactly once, in the deepest Node whose grown bounds fit it. Internal Nodes can store Elements too.
+	struct QuadTreeLoose
+	{
+		constexpr static bool s_Loose = true;
+		constexpr static float s_Looseness = .5f;
+	};
+
+	// DERIVED is the class that derives from QuadTreeElement, if only one does. Then its IsContainedBy, Intersects, and ResolveCollision are called directly instead of through the vtable, so they can be inlined into the loops that use them. void allows any number of derived classes.
+	template<uint THRESHOLD, typename POLICY = QuadTreeStrict, typename DERIVED = void>
 	class QuadTreeElement;
 
-	template<uint THRESHOLD>
+	template<uint THRESHOLD, typename POLICY = QuadTreeStrict, typename DERIVED = void>
 	class QuadTreeNode
 	{
-	private:
-		typedef QuadTreeNode<THRESHOLD> Node;
-		typedef QuadTreeElement<THRESHOLD> Element;
-		typedef LinkedListNode<Element> ElementNode;
-		friend class QuadTreeElement<THRESHOLD>;
 	public:
+		typedef QuadTreeNode<THRESHOLD, POLICY, DERIVED> Node;
+		typedef QuadTreeElement<THRESHOLD, POLICY, DERIVED> Element;
+		typedef LinkedListNode<Element> ElementNode;
+		typedef StaticGrid<Element> Statics;
+		friend class QuadTreeElement<THRESHOLD, POLICY, DERIVED>;
+		friend class Pool<Node>;
+
+
+		struct Stats
+		{
+			// capacity, current use, and peak use of the Node and ElementNode pools
+			uint nodePoolSize, nodesUsed, nodesPeak;
+			uint elementPoolSize, elementsUsed, elementsPeak;
+			// number of QuadTreeElement::Move calls that changed position/size, and how many of those were handled without going back to the root
+			uint moves, reinsertsAvoided;
+			// number of Nodes that divided and merged between the last two calls to EndFrame
+			uint divides, merges;
+		};
+
+
 		QuadTreeNode(const math::Vec2<float>& min, const math::Vec2<float>& max);
 		QuadTreeNode(const Node& other) = delete;
 		QuadTreeNode(Node&& other) = delete;
@@ -33,6 +66,27 @@ namespace math
 
 
 		void Add(Element* e);
+		// Add a whole batch of Elements to an empty tree at once. The result is the same as calling Add for each of them, but every Node is created once, already knowing everything it contains, instead of being filled up and then repeatedly divided.
+		void Build(Element* const* const elements, uint count);
+		// Elements that never move can be kept out of the tree entirely and handed over here instead. Collisions and queries check them alongside the Elements stored in the tree. The tree doesn't take ownership.
+		void SetStatics(const Statics* const statics)
+		{
+			m_Storage->statics = statics;
+		}
+		// Each query writes up to `capacity` Elements into `out` and returns how many it wrote. They don't allocate, and an Element stored in several leaves is still only reported once. Elements from SetStatics come after the ones stored in the tree.
+		// Elements whose rect overlaps the given rect (inclusive at the boundaries)
+		uint QueryAABB(const math::Vec2<float>& pos, const math::Vec2<float>& dim, Element** const out, uint capacity) const;
+		// Elements whose rect contains the given point (inclusive at the boundaries)
+		uint QueryPoint(const math::Vec2<float>& point, Element** const out, uint capacity) const;
+		// Elements hit by the segment from ray.origin to ray.origin + ray.direction, as defined by Ray::IntersectsRect. If `times` isn't null, the time of impact of out[i] is written to times[i].
+		uint QueryRay(const math::Ray<float>& ray, Element** const out, float* const times, uint capacity) const;
+		// Nodes normally try to merge as soon as an Element leaves them. With deferred merges they're only marked, and EndFrame merges everything that's still sparse enough at once. Merging then also waits until the children hold at most THRESHOLD / 2 Elements (dividing still happens past THRESHOLD), so an Element that keeps crossing a boundary doesn't make a Node divide and merge every frame.
+		void SetDeferredMerges(bool deferred)
+		{
+			m_Storage->deferMerges = deferred;
+		}
+		// Call once per frame, after everything has moved. Does any deferred merges and starts counting divides/merges for the next frame.
+		void EndFrame();
 		bool IsDivided() const
 		{
 			return m_Children[0];
@@ -53,7 +107,32 @@ namespace math
 		{
 			return m_Dim;
 		}
+		// statistics for the whole tree this Node belongs to
+		Stats GetStats() const
+		{
+			const Storage& s = *m_Storage;
+			return { s.nodes.GetSize(), s.nodes.GetUsed(), s.nodes.GetPeak(), s.elements.GetSize(), s.elements.GetUsed(), s.elements.GetPeak(), s.moves, s.reinsertsAvoided, s.lastDivides, s.lastMerges };
+		}
 	private:
+		// allocations shared by every Node in a tree, owned by the root Node
+		struct Storage
+		{
+			Pool<Node> nodes;
+			Pool<ElementNode> elements;
+			// scratch space for Merge so that it doesn't need a fresh container every time
+			std::vector<Element*> unique;
+			uint moves = 0, reinsertsAvoided = 0;
+			// see SetDeferredMerges. Divides and merges are counted for the current frame, and the totals for the last one are kept for GetStats.
+			bool deferMerges = false;
+			uint divides = 0, merges = 0, lastDivides = 0, lastMerges = 0;
+			// incremented by each query and stamped onto every Element it visits, so that an Element that's in several leaves is only looked at once
+			uint queryEpoch = 0;
+			// Elements that live outside of the tree, see SetStatics
+			const Statics* statics = nullptr;
+		};
+
+
+
 		// number of child Nodes each Node can contain, minimum side length of a Node (in simulated pixels)
 		constexpr static uint s_Children = 4, s_MinDim = 2;
 		// list of Elements contained by this Node
@@ -64,110 +143,226 @@ namespace math
 		math::Vec2<float> m_Pos;
 		// side length, number of contained Elements
 		uint m_Dim, m_Count;
+		Storage* m_Storage;
+		// with deferred merges: this Node should try to merge at the end of the frame, and this Node or one of its descendants should
+		bool m_MergePending, m_PendingBelow;
 
 
-		QuadTreeNode(const math::Vec2<float>& pos, uint size, Node* const parent = nullptr);
+		QuadTreeNode(const math::Vec2<float>& pos, uint size, Node* const parent);
 
 
+		// Build, starting from a Node that's overlapped by everything in buffer[begin, end)
+		void BuildFrom(std::vector<Element*>& buffer, size_t begin, size_t end);
+		void Store(Element* e);
 		void DeleteElement(ElementNode* element);
 		void DeleteData();
 		void Divide();
-		void GetUniqueElements(std::unordered_set<Element*>* const elements) const;
-		void Merge();
+		void GetElements(std::vector<Element*>* const elements) const;
+		// merges this Node's children into it if they hold no more than `threshold` Elements between them. Returns true if it did.
+		bool Merge(uint threshold = THRESHOLD);
+		// Merge now, or mark this Node to be merged in EndFrame with deferred merges
+		void RequestMerge();
+		// does the deferred merges in this subtree, deepest first. Returns true if this Node merged.
+		bool FlushMerges();
+		template<typename NODE_TEST, typename ELEMENT_TEST>
+		uint Query(const NODE_TEST& nodeTest, const ELEMENT_TEST& elementTest, Element** const out, uint capacity) const
+		{
+			uint& epoch = m_Storage->queryEpoch;
+			// Elements start out stamped with 0, so skip it when we wrap around
+			if (++epoch == 0)
+				epoch = 1;
+
+			uint count = 0;
+			Gather(nodeTest, elementTest, epoch, out, capacity, &count);
+			return count;
+		}
+		template<typename NODE_TEST, typename ELEMENT_TEST>
+		void Gather(const NODE_TEST& nodeTest, const ELEMENT_TEST& elementTest, uint epoch, Element** const out, uint capacity, uint* const count) const
+		{
+			if (*count == capacity || !nodeTest(this))
+				return;
+
+			// only leaves store Elements in a strict tree, but any Node can in a loose one
+			for (ElementNode* cur = m_Data; cur && *count < capacity; cur = cur->next)
+			{
+				Element* const e = cur->data;
+				// already looked at this Element during this query. Loose trees store each Element once, so they never need this.
+				if constexpr (!POLICY::s_Loose)
+				{
+					if (e->m_QueryStamp == epoch)
+						continue;
+					e->m_QueryStamp = epoch;
+				}
+
+				if (elementTest(e, *count))
+					out[(*count)++] = e;
+			}
+
+			if (IsDivided())
+				for (uint i = 0; i < s_Children; i++)
+					m_Children[i]->Gather(nodeTest, elementTest, epoch, out, capacity, count);
+		}
+		// calls fn(Element*) for every Element stored in a Node that overlaps the given rect. Each Element in a loose tree is visited once, but one in a strict tree is visited once per leaf.
+		template<typename FN>
+		void ForEachOverlapping(const math::Vec2<float>& pos, const math::Vec2<float>& dim, const FN& fn) const
+		{
+			if (Overlaps(pos, dim))
+				VisitOverlapping(pos.x, pos.y, pos.x + dim.x, pos.y + dim.y, fn);
+		}
+		// ForEachOverlapping once we already know the rect overlaps this Node
+		template<typename FN>
+		void VisitOverlapping(float minx, float miny, float maxx, float maxy, const FN& fn) const
+		{
+			for (ElementNode* cur = m_Data; cur; cur = cur->next)
+				fn(cur->data);
+
+			if (!IsDivided())
+				return;
+
+			// each child's (loose) bounds reach `grow` past the midlines of this Node, so which children we overlap only takes a few comparisons against them
+			const float half = m_Dim / 2.f, grow = POLICY::s_Looseness * half;
+			const float midx = m_Pos.x + half, midy = m_Pos.y + half;
+			const bool left = minx <= midx + grow && m_Pos.x - grow <= maxx, right = midx - grow <= maxx && minx <= m_Pos.x + m_Dim + grow;
+			const bool bottom = miny <= midy + grow && m_Pos.y - grow <= maxy, top = midy - grow <= maxy && miny <= m_Pos.y + m_Dim + grow;
+			// same order as the offsets in Divide
+			if (bottom && left)
+				m_Children[0]->VisitOverlapping(minx, miny, maxx, maxy, fn);
+			if (bottom && right)
+				m_Children[1]->VisitOverlapping(minx, miny, maxx, maxy, fn);
+			if (top && right)
+				m_Children[2]->VisitOverlapping(minx, miny, maxx, maxy, fn);
+			if (top && left)
+				m_Children[3]->VisitOverlapping(minx, miny, maxx, maxy, fn);
+		}
+		// bottom left corner and side length of the area that the Elements stored in this Node can occupy. Same as the Node itself unless the tree is loose.
+		math::Vec2<float> GetLoosePos() const
+		{
+			return m_Pos - POLICY::s_Looseness * m_Dim;
+		}
+		float GetLooseDim() const
+		{
+			return (1.f + 2.f * POLICY::s_Looseness) * m_Dim;
+		}
+		// true if the given rect overlaps this Node's (loose) bounds (inclusive at the boundaries)
+		bool Overlaps(const math::Vec2<float>& pos, const math::Vec2<float>& dim) const
+		{
+			const math::Vec2<float> lp = GetLoosePos();
+			const float side = GetLooseDim();
+			return pos.x <= lp.x + side && lp.x <= pos.x + dim.x && pos.y <= lp.y + side && lp.y <= pos.y + dim.y;
+		}
+		// true if the given rect fits inside this Node's loose bounds (inclusive at the boundaries)
+		bool LooselyContains(const math::Vec2<float>& pos, const math::Vec2<float>& dim) const
+		{
+			const math::Vec2<float> lp = GetLoosePos();
+			const float side = GetLooseDim();
+			return lp.x <= pos.x && pos.x + dim.x <= lp.x + side && lp.y <= pos.y && pos.y + dim.y <= lp.y + side;
+		}
+		// loose trees only: the child whose quadrant holds the center of the given rect, if the rect fits in that child's loose bounds. Otherwise null.
+		Node* FindChild(const math::Vec2<float>& pos, const math::Vec2<float>& dim) const
+		{
+			const math::Vec2<float> center = pos + dim / 2.f, half = m_Pos + m_Dim / 2.f;
+			const bool right = center.x >= half.x, top = center.y >= half.y;
+			// same order as the offsets in Divide
+			Node* const child = m_Children[top ? (right ? 2 : 3) : (right ? 1 : 0)];
+			return child->LooselyContains(pos, dim) ? child : nullptr;
+		}
+		// true if the given rect lies strictly inside this Node, meaning it can't touch any Node outside of this one's subtree
+		bool Encloses(const math::Vec2<float>& pos, const math::Vec2<float>& dim) const
+		{
+			const float side = CAST(float, m_Dim);
+			return m_Pos.x < pos.x && pos.x + dim.x < m_Pos.x + side && m_Pos.y < pos.y && pos.y + dim.y < m_Pos.y + side;
+		}
 	};
 
 
 	/**
 	 * QuadTreeElement.h
 	 */
-	template<uint THRESHOLD>
-	class QuadTreeElement
+	template<uint THRESHOLD, typename POLICY, typename DERIVED>
+	class QuadTreeElement : public CollisionElement<QuadTreeElement<THRESHOLD, POLICY, DERIVED>, DERIVED>
 	{
 	protected:
-		typedef QuadTreeNode<THRESHOLD> Node;
-		typedef QuadTreeElement<THRESHOLD> Element;
+		typedef QuadTreeNode<THRESHOLD, POLICY, DERIVED> Node;
+		typedef QuadTreeElement<THRESHOLD, POLICY, DERIVED> Element;
+		typedef CollisionElement<Element, DERIVED> Collider;
 		typedef LinkedListNode<Element> ElementNode;
-		friend class QuadTreeNode<THRESHOLD>;
+		friend class QuadTreeNode<THRESHOLD, POLICY, DERIVED>;
+		friend Collider;
 
 
-		struct CollisionInfo
+		struct Parent
 		{
-			Element* element;
-			Vec2<float> normal, contact;
-			float time;
-		};
-		struct NodeComparator
-		{
-			const bool operator()(const Node* const a, const Node* const b) const;
+			// Node that contains this Element and the ElementNode within that Node that this Element is actually stored in
+			Node* node;
+			ElementNode* container;
 		};
+		// an Element is almost never in more than 4 leaves, anything past that spills to the heap
+		constexpr static uint s_InlineParents = 4;
+		typedef SmallVector<Parent, s_InlineParents> ParentList;
+		typedef SmallVector<Node*, s_InlineParents> NodeList;
 	public:
 		QuadTreeElement(const math::Vec2<float>& pos, const math::Vec2<float>& dim, const math::Vec2<float>& vel);
 		QuadTreeElement(const Element& other) = delete;
 		QuadTreeElement(Element&& other) noexcept :
-			m_Pos(other.m_Pos),
-			m_Vel(other.m_Vel),
-			m_Dim(other.m_Dim),
+			Collider(std::move(other)),
 			m_Parents(std::move(other.m_Parents)),
-			m_Grandparents(std::move(other.m_Grandparents)),
-			m_Checked(std::move(other.m_Checked)),
-			m_GrandparentCount(std::move(other.m_GrandparentCount))
+			m_QueryStamp(other.m_QueryStamp)
 		{}
-		virtual ~QuadTreeElement() {}
 
 
-		virtual void ResolveCollision(const CollisionInfo& info) = 0;
+		using Collider::Update;
 		void Move(const math::Vec2<float>& pos, const math::Vec2<float>& dim, const math::Vec2<float>& vel, Node* const root);
 		void Update(float delta);
-		const math::Vec2<float>& GetPos() const
-		{
-			return m_Pos;
-		}
-		const math::Vec2<float>& GetVel() const
-		{
-			return m_Vel;
-		}
-		const math::Vec2<float>& GetDim() const
-		{
-			return m_Dim;
-		}
-		const void SetPos(const math::Vec2<float>& pos)
-		{
-			m_Pos = pos;
-		}
-		const void SetVel(const math::Vec2<float>& vel)
-		{
-			m_Vel = vel;
-		}
 	protected:
-		constexpr static uint s_MapReserveSize = THRESHOLD * THRESHOLD * THRESHOLD;
-		// position, size, and velocity of the "host" object
-		Vec2<float> m_Pos, m_Dim, m_Vel;
-		// stores this Nodes that contain this Element and the ElementNode within each Node that they are actually stored in
-		std::unordered_map<Node*, ElementNode*> m_Parents;
-		// set of parent Nodes of all the Nodes in m_Parents
-		std::set<Node*, NodeComparator> m_Grandparents;
-		// marked as mutable to signify they aren't part of the object's logical state
-		mutable std::unordered_set<Element*> m_Checked;
-		mutable std::unordered_map<Node*, uint> m_GrandparentCount;
+		using Collider::m_Pos;
+		using Collider::m_Dim;
+		using Collider::m_Vel;
+		using Collider::CopyHostValues;
+		using Collider::Collide;
+		// leaf Nodes that contain this Element. Grandparents aren't stored, they're just the m_Parent of each of these.
+		ParentList m_Parents;
+		// epoch of the last QuadTreeNode query that visited this Element
+		mutable uint m_QueryStamp;
 
 
 		virtual bool IsContainedBy(const Node* const node) const = 0;
-		virtual bool Intersects(const Element* const other, float delta, Vec2<float>* const normal, Vec2<float>* const contact, float* const time) const = 0;
+		// IsContainedBy, called on DERIVED directly if there is one (see CollisionElement::CallIntersects)
+		bool CallIsContainedBy(const Node* const node) const
+		{
+			if constexpr (std::is_void_v<DERIVED>)
+				return IsContainedBy(node);
+			else
+				return CAST(const DERIVED*, this)->DERIVED::IsContainedBy(node);
+		}
+		// for CollisionElement::Gather. We can only get to the statics through a tree we're in.
+		const typename Node::Statics* GetStatics() const
+		{
+			return m_Parents.IsEmpty() ? nullptr : m_Parents[0].node->m_Storage->statics;
+		}
 		void AddTo(Node* const node, ElementNode* const container);
 		void RemoveFrom(Node* const node);
+		void RemoveFromSubtree(const Node* const node);
 		void Delete();
 		void RemoveFromParents();
-		void TryRemoveGrandparent(Node* const gp);
-		void Merge(std::set<Node*, NodeComparator>& grandparents)
+		// Move for a loose tree, once we know we're already in it
+		void MoveLoose();
+		uint FindParent(const Node* const node) const
+		{
+			uint i = 0;
+			while (i < m_Parents.GetSize() && m_Parents[i].node != node)
+				i++;
+			return i;
+		}
+		bool HasParent(const Node* const node) const
 		{
-			for (auto& gp : grandparents)
-				gp->Merge();
+			return FindParent(node) != m_Parents.GetSize();
 		}
-		void CopyHostValues(const Vec2<float>& pos, const Vec2<float>& dim, const Vec2<float>& vel)
+		// unique parents of all the Nodes in m_Parents, smallest first
+		void GetGrandparents(NodeList* const grandparents) const;
+		void Merge(const NodeList& grandparents)
 		{
-			m_Pos = pos;
-			m_Dim = dim;
-			m_Vel = vel;
+			for (Node* gp : grandparents)
+				gp->RequestMerge();
 		}
 	};
 
@@ -175,34 +370,70 @@ namespace math
 	/**
 	 * QuadTreeNode.cpp
 	 */
-	template<uint THRESHOLD>
-	QuadTreeNode<THRESHOLD>::QuadTreeNode(const math::Vec2<float>& min, const math::Vec2<float>& max) :
+	template<uint THRESHOLD, typename POLICY, typename DERIVED>
+	QuadTreeNode<THRESHOLD, POLICY, DERIVED>::QuadTreeNode(const math::Vec2<float>& min, const math::Vec2<float>& max) :
 		m_Data(nullptr),
 		m_Children{ nullptr },
 		m_Parent(nullptr),
 		m_Pos(min),
 		m_Dim(0),
-		m_Count(0)
+		m_Count(0),
+		m_Storage(new Storage()),
+		m_MergePending(false),
+		m_PendingBelow(false)
 	{
 		// determine the amount of space this quad tree has to span
 		const Vec2<float> diff = max - min;
 		// our implementation (using a minimum dimension) must be able to be divided cleanly until m_Dim = 2. The only way to ensure this is to make the side length of the root node a power of 2.
 		m_Dim = nextPower(2, math::max(diff.x, diff.y));
 	}
-	template<uint THRESHOLD>
-	QuadTreeNode<THRESHOLD>::~QuadTreeNode()
+	template<uint THRESHOLD, typename POLICY, typename DERIVED>
+	QuadTreeNode<THRESHOLD, POLICY, DERIVED>::~QuadTreeNode()
 	{
 		// delete storage for all the Elements this Node contains
 		DeleteData();
 
 		// recursively delete all child Nodes
 		for (uint i = 0; i < s_Children; i++)
-			delete m_Children[i];
+			m_Storage->nodes.Delete(m_Children[i]);
+
+		// the root owns the storage for the whole tree, and all of its descendants are gone by now
+		if (!m_Parent)
+			delete m_Storage;
 	}
-	template<uint THRESHOLD>
-	void QuadTreeNode<THRESHOLD>::Add(Element* e)
+	template<uint THRESHOLD, typename POLICY, typename DERIVED>
+	void QuadTreeNode<THRESHOLD, POLICY, DERIVED>::Add(Element* e)
 	{
-		if (!e->IsContainedBy(this))
+		if constexpr (POLICY::s_Loose)
+		{
+			if (!LooselyContains(e->m_Pos, e->m_Dim))
+			{
+				if (!m_Parent)
+				{
+					const auto& pos = e->m_Pos, dim = e->m_Dim;
+					printf("QuadTree [(%f, %f), (%f, %f)] cannot contain element [(%f, %f), (%f, %f)]\n", m_Pos.x, m_Pos.y, m_Pos.x + m_Dim, m_Pos.y + m_Dim, pos.x, pos.y, pos.x + dim.x, pos.y + dim.y);
+				}
+				return;
+			}
+
+			// go as deep as the Element fits
+			Node* node = this;
+			while (node->IsDivided())
+			{
+				Node* const child = node->FindChild(e->m_Pos, e->m_Dim);
+				if (!child)
+					break;
+				node = child;
+			}
+			node->Store(e);
+
+			// a leaf that's over the threshold pushes whatever it can down into new children
+			if (!node->IsDivided() && node->m_Count > THRESHOLD && node->m_Dim > s_MinDim)
+				node->Divide();
+			return;
+		}
+
+		if (!e->CallIsContainedBy(this))
 		{
 			// if this Node is the root and even it doesn't contain the given Element, the Element is outside of the area controlled by this QuadTree
 			if (!m_Parent)
@@ -213,6 +444,10 @@ namespace math
 			return;
 		}
 
+		// the Element is already stored here (can happen when QuadTreeElement::Move re-adds from partway up the tree)
+		if (!IsDivided() && e->HasParent(this))
+			return;
+
 		// if we already have the threshold number of Elements, preemptively divide
 		if (m_Count == THRESHOLD)
 			Divide();
@@ -223,40 +458,104 @@ namespace math
 				m_Children[i]->Add(e);
 		// non-divided Nodes must store Elements
 		else
+			Store(e);
+	}
+	template<uint THRESHOLD, typename POLICY, typename DERIVED>
+	void QuadTreeNode<THRESHOLD, POLICY, DERIVED>::Build(Element* const* const elements, uint count)
+	{
+		// we can only build top down from an empty root. Loose trees are cheap to add to anyway.
+		if (POLICY::s_Loose || m_Parent || m_Data || IsDivided())
 		{
-			// this will become the head of our list of Elements
-			ElementNode* node = new ElementNode();
-			node->data = e;
-			// no nodes to the left
-			node->prev = nullptr;
+			for (uint i = 0; i < count; i++)
+				Add(elements[i]);
+			return;
+		}
 
-			// if we already have some Elements
-			if (m_Data)
+		// every range of this buffer is the list of Elements for one Node. Each Node appends its children's lists to the end while it builds them, then throws them away.
+		std::vector<Element*> buffer;
+		buffer.reserve(2 * count);
+		for (uint i = 0; i < count; i++)
+		{
+			// same check as Add
+			if (elements[i]->CallIsContainedBy(this))
+				buffer.push_back(elements[i]);
+			else
 			{
-				// new node has stuff on the right
-				node->next = m_Data;
-				// old head now has something on the left
-				m_Data->prev = node;
+				const auto& pos = elements[i]->m_Pos, dim = elements[i]->m_Dim;
+				printf("QuadTree [(%f, %f), (%f, %f)] cannot contain element [(%f, %f), (%f, %f)]\n", m_Pos.x, m_Pos.y, m_Pos.x + m_Dim, m_Pos.y + m_Dim, pos.x, pos.y, pos.x + dim.x, pos.y + dim.y);
 			}
-			// make this the new head
-			m_Data = node;
-			m_Count++;
+		}
+		BuildFrom(buffer, 0, buffer.size());
+	}
+	template<uint THRESHOLD, typename POLICY, typename DERIVED>
+	void QuadTreeNode<THRESHOLD, POLICY, DERIVED>::BuildFrom(std::vector<Element*>& buffer, size_t begin, size_t end)
+	{
+		// Add divides a Node as soon as more than THRESHOLD Elements touch it, so that's exactly when we divide too
+		if (end - begin <= THRESHOLD || m_Dim <= s_MinDim)
+		{
+			if (end - begin > THRESHOLD)
+				printf("Cannot divide QuadTreeNode further, intersecting objects must have been inserted\n");
+			for (size_t i = begin; i < end; i++)
+				Store(buffer[i]);
+			return;
+		}
+
+		const math::Vec2<float> offsets[s_Children] = { {0.f, 0.f}, {.5f, 0.f}, {.5f, .5f}, {0.f, .5f} };
+		for (uint i = 0; i < s_Children; i++)
+		{
+			Node* child = m_Storage->nodes.New(m_Pos + offsets[i] * CAST(float, m_Dim), m_Dim / 2, this);
+			m_Children[i] = child;
 
-			// handles adding to parent/grandparent containers
-			e->AddTo(this, node);
+			// gather up everything that touches this child and build it from that
+			const size_t start = buffer.size();
+			for (size_t j = begin; j < end; j++)
+			{
+				Element* const e = buffer[j];
+				if (e->CallIsContainedBy(child))
+					buffer.push_back(e);
+			}
+			child->BuildFrom(buffer, start, buffer.size());
+			buffer.resize(start);
 		}
 	}
-	template<uint THRESHOLD>
-	QuadTreeNode<THRESHOLD>::QuadTreeNode(const math::Vec2<float>& pos, uint size, Node* const parent) :
+	template<uint THRESHOLD, typename POLICY, typename DERIVED>
+	QuadTreeNode<THRESHOLD, POLICY, DERIVED>::QuadTreeNode(const math::Vec2<float>& pos, uint size, Node* const parent) :
 		m_Data(nullptr),
 		m_Children{ nullptr },
 		m_Parent(parent),
 		m_Pos(pos),
 		m_Dim(size),
-		m_Count(0)
+		m_Count(0),
+		m_Storage(parent->m_Storage),
+		m_MergePending(false),
+		m_PendingBelow(false)
 	{}
-	template<uint THRESHOLD>
-	void QuadTreeNode<THRESHOLD>::DeleteElement(ElementNode* element)
+	template<uint THRESHOLD, typename POLICY, typename DERIVED>
+	void QuadTreeNode<THRESHOLD, POLICY, DERIVED>::Store(Element* e)
+	{
+		// this will become the head of our list of Elements
+		ElementNode* node = m_Storage->elements.New();
+		node->data = e;
+		// no nodes to the left
+		node->prev = nullptr;
+
+		// if we already have some Elements
+		if (m_Data)
+		{
+			// new node has stuff on the right
+			node->next = m_Data;
+			// old head now has something on the left
+			m_Data->prev = node;
+		}
+		// make this the new head
+		m_Data = node;
+		m_Count++;
+
+		// handles adding to parent/grandparent containers
+		e->AddTo(this, node);
+	}
+	template<uint THRESHOLD, typename POLICY, typename DERIVED>
+	void QuadTreeNode<THRESHOLD, POLICY, DERIVED>::DeleteElement(ElementNode* element)
 	{
 		// link left and right elements around this node before deleting
 		if (element->prev)
@@ -268,26 +567,26 @@ namespace math
 			m_Data = element->next;
 
 		// finally actually delete it
-		delete element;
+		m_Storage->elements.Delete(element);
 		m_Count--;
 	}
-	template<uint THRESHOLD>
-	void QuadTreeNode<THRESHOLD>::DeleteData()
+	template<uint THRESHOLD, typename POLICY, typename DERIVED>
+	void QuadTreeNode<THRESHOLD, POLICY, DERIVED>::DeleteData()
 	{
 		// delete all contained ElementNodes (not the Elements themselves, just the storage for them within this Node)
 		ElementNode* cur = m_Data;
 		while (cur)
 		{
 			ElementNode* next = cur->next;
-			delete cur;
+			m_Storage->elements.Delete(cur);
 			cur = next;
 		}
 		// important to reset count/pointers
 		m_Data = nullptr;
 		m_Count = 0;
 	}
-	template<uint THRESHOLD>
-	void QuadTreeNode<THRESHOLD>::Divide()
+	template<uint THRESHOLD, typename POLICY, typename DERIVED>
+	void QuadTreeNode<THRESHOLD, POLICY, DERIVED>::Divide()
 	{
 		// a Node can't be smaller than 2x2 because that means we're inserting intersecting objects
 		if (m_Dim <= s_MinDim)
@@ -295,6 +594,31 @@ namespace math
 			printf("Cannot divide QuadTreeNode further, intersecting objects must have been inserted\n");
 			return;
 		}
+		m_Storage->divides++;
+
+		const math::Vec2<float> offsets[s_Children] = { {0.f, 0.f}, {.5f, 0.f}, {.5f, .5f}, {0.f, .5f} };
+		if constexpr (POLICY::s_Loose)
+		{
+			for (uint i = 0; i < s_Children; i++)
+				m_Children[i] = m_Storage->nodes.New(m_Pos + offsets[i] * CAST(float, m_Dim), m_Dim / 2, this);
+
+			// move down every Element that fits in one of the new children, anything else stays here
+			ElementNode* cur = m_Data;
+			while (cur)
+			{
+				ElementNode* const next = cur->next;
+				Element* const e = cur->data;
+				Node* const child = FindChild(e->m_Pos, e->m_Dim);
+				if (child)
+				{
+					e->RemoveFrom(this);
+					DeleteElement(cur);
+					child->Add(e);
+				}
+				cur = next;
+			}
+			return;
+		}
 
 		// remove this Node from each of its contained Elements' caches
 		ElementNode* cur = m_Data;
@@ -305,10 +629,9 @@ namespace math
 		}
 
 		// create child Nodes
-		const math::Vec2<float> offsets[s_Children] = { {0.f, 0.f}, {.5f, 0.f}, {.5f, .5f}, {0.f, .5f} };
 		for (uint i = 0; i < s_Children; i++)
 		{
-			Node* child = new Node(m_Pos + offsets[i] * CAST(float, m_Dim), m_Dim / 2, this);
+			Node* child = m_Storage->nodes.New(m_Pos + offsets[i] * CAST(float, m_Dim), m_Dim / 2, this);
 			// attempt to add all of this Node's Elements to each of the new children
 			cur = m_Data;
 			while (cur)
@@ -323,99 +646,234 @@ namespace math
 		// now that this Node is divided, it can only contain children, so delete the ElementNodes
 		DeleteData();
 	}
-	template<uint THRESHOLD>
-	void QuadTreeNode<THRESHOLD>::GetUniqueElements(std::unordered_set<Element*>* const elements) const
+	template<uint THRESHOLD, typename POLICY, typename DERIVED>
+	void QuadTreeNode<THRESHOLD, POLICY, DERIVED>::GetElements(std::vector<Element*>* const elements) const
 	{
-		if (!IsDivided())
+		// only leaves store Elements in a strict tree, but any Node can in a loose one
+		ElementNode* cur = m_Data;
+		while (cur)
 		{
-			ElementNode* cur = m_Data;
-			while (cur)
-			{
-				elements->insert(cur->data);
-				cur = cur->next;
-			}
+			elements->push_back(cur->data);
+			cur = cur->next;
 		}
-		else
+
+		if (IsDivided())
 			for (uint i = 0; i < s_Children; i++)
-				m_Children[i]->GetUniqueElements(elements);
+				m_Children[i]->GetElements(elements);
 	}
-	template<uint THRESHOLD>
-	void QuadTreeNode<THRESHOLD>::Merge()
+	template<uint THRESHOLD, typename POLICY, typename DERIVED>
+	bool QuadTreeNode<THRESHOLD, POLICY, DERIVED>::Merge(uint threshold)
 	{
 		if (!IsDivided())
 		{
 			printf("Cannot merge a QuadTreeNode that is not divided\n");
-			return;
+			return false;
 		}
 
-		// get the unique elements that all of this Node's children contain
-		std::unordered_set<Element*> elements;
-		GetUniqueElements(&elements);
+		// get the unique elements that all of this Node's children contain. An Element can be in several children, so sort the list and drop the duplicates.
+		std::vector<Element*>& elements = m_Storage->unique;
+		elements.clear();
+		for (uint i = 0; i < s_Children; i++)
+			m_Children[i]->GetElements(&elements);
+		std::sort(elements.begin(), elements.end());
+		elements.erase(std::unique(elements.begin(), elements.end()), elements.end());
 
-		// if the total number of Elements within this Node's space is within the threshold range, we can just store them all in this Node directly
-		if (elements.size() <= THRESHOLD)
+		// if the total number of Elements within this Node's space (including any a loose Node stores itself) is within the threshold range, we can just store them all in this Node directly
+		if (m_Count + elements.size() > threshold)
+			return false;
+
+		// remove each Element from all of this Node's descendants (children may themselves be divided)
+		for (Element* cur : elements)
+			cur->RemoveFromSubtree(this);
+
+		// delete children
+		for (uint i = 0; i < s_Children; i++)
 		{
-			// remove each Element from all of this Node's children
-			for (Element* cur : elements)
-			{
-				cur->m_Grandparents.erase(this);
-				auto& parents = cur->m_Parents;
-				for (uint i = 0; i < s_Children; i++)
-					parents.erase(m_Children[i]);
-			}
+			m_Storage->nodes.Delete(m_Children[i]);
+			m_Children[i] = nullptr;
+		}
 
-			// delete children
-			for (uint i = 0; i < s_Children; i++)
-			{
-				delete m_Children[i];
-				m_Children[i] = nullptr;
-			}
+		// add each Element to this Node
+		for (Element* cur : elements)
+			Add(cur);
 
-			// add each Element to this Node
-			for (Element* cur : elements)
-				Add(cur);
+		m_Storage->merges++;
+		return true;
+	}
+	template<uint THRESHOLD, typename POLICY, typename DERIVED>
+	void QuadTreeNode<THRESHOLD, POLICY, DERIVED>::RequestMerge()
+	{
+		if (!m_Storage->deferMerges)
+		{
+			Merge();
+			return;
 		}
+
+		// mark the path up to the root so that EndFrame only has to visit the parts of the tree that changed
+		m_MergePending = true;
+		for (Node* node = this; node && !node->m_PendingBelow; node = node->m_Parent)
+			node->m_PendingBelow = true;
+	}
+	template<uint THRESHOLD, typename POLICY, typename DERIVED>
+	bool QuadTreeNode<THRESHOLD, POLICY, DERIVED>::FlushMerges()
+	{
+		if (!m_PendingBelow)
+			return false;
+		m_PendingBelow = false;
+
+		// Children go first, because merging deletes them. One of them merging might leave us sparse enough to merge too.
+		bool childMerged = false;
+		if (IsDivided())
+			for (uint i = 0; i < s_Children; i++)
+				childMerged |= m_Children[i]->FlushMerges();
+
+		const bool merge = (m_MergePending || childMerged) && IsDivided();
+		m_MergePending = false;
+		return merge && Merge(THRESHOLD / 2);
+	}
+	template<uint THRESHOLD, typename POLICY, typename DERIVED>
+	void QuadTreeNode<THRESHOLD, POLICY, DERIVED>::EndFrame()
+	{
+		Node* root = this;
+		while (root->m_Parent)
+			root = root->m_Parent;
+		root->FlushMerges();
+
+		Storage& storage = *m_Storage;
+		storage.lastDivides = storage.divides;
+		storage.lastMerges = storage.merges;
+		storage.divides = 0;
+		storage.merges = 0;
 	}
 
 
 
-	/**
-	 * QuadTreeElement.h
-	 */
-	template<uint THRESHOLD>
-	const bool QuadTreeElement<THRESHOLD>::NodeComparator::operator()(const Node* const a, const Node* const b) const
+	template<uint THRESHOLD, typename POLICY, typename DERIVED>
+	uint QuadTreeNode<THRESHOLD, POLICY, DERIVED>::QueryAABB(const math::Vec2<float>& pos, const math::Vec2<float>& dim, Element** const out, uint capacity) const
 	{
-		// gives smaller Nodes a higher priority, meaning that they will be merged first
-		return a && b && a->m_Dim < b->m_Dim;
+		const uint count = Query(
+			[&](const Node* const node) { return node->Overlaps(pos, dim); },
+			[&](const Element* const e, uint index)
+			{
+				const auto& ep = e->m_Pos, ed = e->m_Dim;
+				return pos.x <= ep.x + ed.x && ep.x <= pos.x + dim.x && pos.y <= ep.y + ed.y && ep.y <= pos.y + dim.y;
+			},
+			out, capacity);
+
+		const Statics* const statics = m_Storage->statics;
+		return count + (statics ? statics->QueryAABB(pos, dim, out + count, capacity - count) : 0);
 	}
-	template<uint THRESHOLD>
-	QuadTreeElement<THRESHOLD>::QuadTreeElement(const math::Vec2<float>& pos, const math::Vec2<float>& dim, const math::Vec2<float>& vel) :
-		m_Pos(pos),
-		m_Dim(dim),
-		m_Vel(vel)
+	template<uint THRESHOLD, typename POLICY, typename DERIVED>
+	uint QuadTreeNode<THRESHOLD, POLICY, DERIVED>::QueryPoint(const math::Vec2<float>& point, Element** const out, uint capacity) const
 	{
-		m_Checked.reserve(s_MapReserveSize);
+		return QueryAABB(point, { 0.f, 0.f }, out, capacity);
 	}
-	template<uint THRESHOLD>
-	void QuadTreeElement<THRESHOLD>::Move(const math::Vec2<float>& pos, const math::Vec2<float>& dim, const math::Vec2<float>& vel, Node* const root)
+	template<uint THRESHOLD, typename POLICY, typename DERIVED>
+	uint QuadTreeNode<THRESHOLD, POLICY, DERIVED>::QueryRay(const math::Ray<float>& ray, Element** const out, float* const times, uint capacity) const
+	{
+		// IntersectsRect isn't const
+		math::Ray<float> r = ray;
+		const uint count = Query(
+			[&](const Node* const node)
+			{
+				// a segment that starts inside a Node never "hits" it as far as IntersectsRect is concerned, but it still needs to be searched
+				const float side = node->GetLooseDim();
+				return node->Overlaps(r.origin, { 0.f, 0.f }) || r.IntersectsRect(node->GetLoosePos(), { side, side }, nullptr, nullptr, nullptr);
+			},
+			[&](const Element* const e, uint index)
+			{
+				float time = 0.f;
+				if (!r.IntersectsRect(e->m_Pos, e->m_Dim, nullptr, nullptr, &time))
+					return false;
+				if (times)
+					times[index] = time;
+				return true;
+			},
+			out, capacity);
+
+		const Statics* const statics = m_Storage->statics;
+		return count + (statics ? statics->QueryRay(ray, out + count, times ? times + count : nullptr, capacity - count) : 0);
+	}
+
+
+
+	/**
+	 * QuadTreeElement.h
+	 */
+	template<uint THRESHOLD, typename POLICY, typename DERIVED>
+	QuadTreeElement<THRESHOLD, POLICY, DERIVED>::QuadTreeElement(const math::Vec2<float>& pos, const math::Vec2<float>& dim, const math::Vec2<float>& vel) :
+		Collider(pos, dim, vel),
+		m_QueryStamp(0)
+	{}
+	template<uint THRESHOLD, typename POLICY, typename DERIVED>
+	void QuadTreeElement<THRESHOLD, POLICY, DERIVED>::Move(const math::Vec2<float>& pos, const math::Vec2<float>& dim, const math::Vec2<float>& vel, Node* const root)
 	{
 		// if position of dimensions have changed, we might need to move around in the tree
 		if (m_Pos != pos || m_Dim != dim)
 		{
 			CopyHostValues(pos, dim, vel);
 
+			// we aren't in the tree at all (we were outside of it), so there's nothing to relocate from
+			if (m_Parents.IsEmpty())
+			{
+				root->Add(this);
+				return;
+			}
+
+			Node* leaf = m_Parents[0].node;
+			auto& storage = *leaf->m_Storage;
+			storage.moves++;
+
+			if constexpr (POLICY::s_Loose)
+			{
+				MoveLoose();
+				return;
+			}
+
+			// most common case by far: we moved a bit but we're still strictly inside the only leaf we're in
+			if (m_Parents.GetSize() == 1 && leaf->Encloses(m_Pos, m_Dim))
+			{
+				storage.reinsertsAvoided++;
+				return;
+			}
+
 			// copy current grandparents
-			std::set<Node*, NodeComparator> originalGrandparents = m_Grandparents;
-			// remove ourselves from the tree
-			RemoveFromParents();
-			m_Grandparents.clear();
-			// add back to the tree with our new position/dimensions
-			root->Add(this);
+			NodeList originalGrandparents;
+			GetGrandparents(&originalGrandparents);
+
+			// remove ourselves from only the leaves we don't touch anymore
+			for (uint i = 0; i < m_Parents.GetSize();)
+			{
+				const Parent& parent = m_Parents[i];
+				if (!CallIsContainedBy(parent.node))
+				{
+					parent.node->DeleteElement(parent.container);
+					m_Parents.Erase(i);
+				}
+				else
+					i++;
+			}
+
+			// climb only as far as we need to in order to find a Node that fully contains us, then go back down from there. Add skips any leaves we're still in.
+			Node* start = leaf;
+			while (start->m_Parent && !start->Encloses(m_Pos, m_Dim))
+				start = start->m_Parent;
+			if (start->m_Parent)
+				storage.reinsertsAvoided++;
+			start->Add(this);
 
 			// remove all new grandparents from our list of old grandparents
-			for (auto gp : m_Grandparents)
-				originalGrandparents.erase(gp);
+			NodeList grandparents;
+			GetGrandparents(&grandparents);
+			for (Node* gp : grandparents)
+			{
+				const uint i = originalGrandparents.Find(gp);
+				if (i != originalGrandparents.GetSize())
+					originalGrandparents.Erase(i);
+			}
 
+			// Erase doesn't preserve order, so restore smallest first before merging
+			std::sort(originalGrandparents.begin(), originalGrandparents.end(), [](const Node* const a, const Node* const b) { return a->m_Dim < b->m_Dim; });
 			// attempt to merge old grandparents
 			Merge(originalGrandparents);
 		}
@@ -423,108 +881,143 @@ namespace math
 		else
 			CopyHostValues(pos, dim, vel);
 	}
-	template<uint THRESHOLD>
-	void QuadTreeElement<THRESHOLD>::Update(float delta)
+	template<uint THRESHOLD, typename POLICY, typename DERIVED>
+	void QuadTreeElement<THRESHOLD, POLICY, DERIVED>::MoveLoose()
 	{
-		// we aren't moving, so we can't cause any collisions
-		if (m_Vel == 0.f)
-			return;
-
-		// to store info about collisions
-		math::Vec2<float> normal = { 0.f, 0.f }, contact = { 0.f, 0.f };
-		float time;
+		const Parent parent = m_Parents[0];
+		auto& storage = *parent.node->m_Storage;
 
-		// no other Elements have been checked this frame
-		m_Checked.clear();
-		// this needs to be a multimap because it's not uncommon for multiple collisions to have the same "time" and regardless of that they all need to get resolved
-		std::multimap<float, CollisionInfo> collisions;
-		// for each parent Node
-		for (const auto& parent : m_Parents)
+		// still inside the loose bounds of the Node we're in, so we can stay unless we now fit deeper down
+		if (parent.node->LooselyContains(m_Pos, m_Dim))
 		{
-			// go through all Elements contained by the current parent
-			ElementNode* node = parent.first->GetFirstElement();
-			while (node)
+			storage.reinsertsAvoided++;
+			Node* const child = parent.node->IsDivided() ? parent.node->FindChild(m_Pos, m_Dim) : nullptr;
+			if (child)
 			{
-				Element* cur = node->data;
-
-				// if not checking against ourselves and we haven't checked this Element yet this frame
-				const auto& it = m_Checked.find(cur);
-				if (cur != this && it == m_Checked.end())
-				{
-					// mark it as a collision if there's an intersection
-					if (Intersects(cur, delta, &normal, &contact, &time))
-						collisions.emplace(time, CollisionInfo(cur, normal, contact, time));
-
-					// regardless, mark it as checked
-					m_Checked.insert(cur);
-				}
-				node = node->next;
+				RemoveFromParents();
+				child->Add(this);
 			}
+			return;
 		}
 
-		// for all marked collisions
-		for (auto& collision : collisions)
-		{
-			CollisionInfo& c = collision.second;
-			// make sure this collision still exists before resolving it
-			if (Intersects(c.element, delta, &c.normal, &c.contact, &c.time))
-				ResolveCollision(c);
-		}
+		// climb only as far as we need to in order to find a Node that fits us, then go back down from there
+		RemoveFromParents();
+		Node* start = parent.node;
+		while (start->m_Parent && !start->LooselyContains(m_Pos, m_Dim))
+			start = start->m_Parent;
+		if (start->m_Parent)
+			storage.reinsertsAvoided++;
+		start->Add(this);
+
+		// the leaf we left might be sparse enough to merge with its siblings now
+		if (parent.node->m_Parent && !parent.node->IsDivided())
+			parent.node->m_Parent->RequestMerge();
 	}
-	template<uint THRESHOLD>
-	void QuadTreeElement<THRESHOLD>::AddTo(Node* const node, ElementNode* const container)
+	template<uint THRESHOLD, typename POLICY, typename DERIVED>
+	void QuadTreeElement<THRESHOLD, POLICY, DERIVED>::Update(float delta)
 	{
-		m_Parents.emplace(node, container);
-
-		Node* const parent = node->m_Parent;
-		if (parent)
+		Collide(delta, [this](const auto& mark, const auto&)
+			{
+				// each Element is only stored once in a loose tree, so just look through every Node we overlap
+				if constexpr (POLICY::s_Loose)
+				{
+					if (!m_Parents.IsEmpty())
+					{
+						const Node* root = m_Parents[0].node;
+						while (root->m_Parent)
+							root = root->m_Parent;
+						// a Node's loose bounds are much bigger than what it actually stores, so do a cheap bounds check before the real one
+						root->ForEachOverlapping(m_Pos, m_Dim, [&](Element* const cur)
+							{
+								const auto& cp = cur->m_Pos, cd = cur->m_Dim;
+								if (cur != this && m_Pos.x <= cp.x + cd.x && cp.x <= m_Pos.x + m_Dim.x && m_Pos.y <= cp.y + cd.y && cp.y <= m_Pos.y + m_Dim.y)
+									mark(cur);
+							});
+					}
+				}
+				else
+				{
+					// for each parent Node
+					for (uint i = 0; i < m_Parents.GetSize(); i++)
+					{
+						// go through all Elements contained by the current parent
+						ElementNode* node = m_Parents[i].node->GetFirstElement();
+						while (node)
+						{
+							Element* cur = node->data;
+
+							// An Element that shares more than one leaf with us shows up once per shared leaf. Only check it in the first one we share, so that each Element gets checked once without keeping a set of everything we've seen.
+							bool checked = (cur == this);
+							for (uint j = 0; !checked && j < i; j++)
+								checked = cur->HasParent(m_Parents[j].node);
+
+							if (!checked)
+								mark(cur);
+
+							node = node->next;
+						}
+					}
+				}
+			});
+	}
+	template<uint THRESHOLD, typename POLICY, typename DERIVED>
+	void QuadTreeElement<THRESHOLD, POLICY, DERIVED>::AddTo(Node* const node, ElementNode* const container)
+	{
+		m_Parents.Push({ node, container });
+	}
+	template<uint THRESHOLD, typename POLICY, typename DERIVED>
+	void QuadTreeElement<THRESHOLD, POLICY, DERIVED>::RemoveFrom(Node* const node)
+	{
+		const uint i = FindParent(node);
+		if (i != m_Parents.GetSize())
+			m_Parents.Erase(i);
+	}
+	template<uint THRESHOLD, typename POLICY, typename DERIVED>
+	void QuadTreeElement<THRESHOLD, POLICY, DERIVED>::RemoveFromSubtree(const Node* const node)
+	{
+		// forget every parent that is (or is below) the given Node. Only used when that subtree is about to be deleted wholesale, so the ElementNodes don't need to be unlinked.
+		for (uint i = 0; i < m_Parents.GetSize();)
 		{
-			m_Grandparents.insert(parent);
+			const Node* cur = m_Parents[i].node;
+			while (cur && cur != node)
+				cur = cur->m_Parent;
 
-			// if one of our parent nodes already has this parent, increment the count
-			const auto& it = m_GrandparentCount.find(parent);
-			if (it != m_GrandparentCount.end())
-				it->second++;
-			// otherwise, create the count and initialize it to 1
+			if (cur)
+				m_Parents.Erase(i);
 			else
-				m_GrandparentCount[parent] = 1;
+				i++;
 		}
 	}
-	template<uint THRESHOLD>
-	void QuadTreeElement<THRESHOLD>::RemoveFrom(Node* const node)
-	{
-		m_Parents.erase(node);
-
-		Node* const parent = node->m_Parent;
-		if (parent)
-			TryRemoveGrandparent(parent);
-	}
-	template<uint THRESHOLD>
-	void QuadTreeElement<THRESHOLD>::Delete()
+	template<uint THRESHOLD, typename POLICY, typename DERIVED>
+	void QuadTreeElement<THRESHOLD, POLICY, DERIVED>::Delete()
 	{
+		NodeList grandparents;
+		GetGrandparents(&grandparents);
 		RemoveFromParents();
-		Merge(m_Grandparents);
-		m_Grandparents.clear();
+		Merge(grandparents);
 	}
-	template<uint THRESHOLD>
-	void QuadTreeElement<THRESHOLD>::RemoveFromParents()
+	template<uint THRESHOLD, typename POLICY, typename DERIVED>
+	void QuadTreeElement<THRESHOLD, POLICY, DERIVED>::RemoveFromParents()
 	{
 		// actually remove this Element from the tree
-		for (const auto& parent : m_Parents)
-			parent.first->DeleteElement(parent.second);
-		m_Parents.clear();
+		for (const Parent& parent : m_Parents)
+			parent.node->DeleteElement(parent.container);
+		m_Parents.Clear();
 	}
-	template<uint THRESHOLD>
-	void QuadTreeElement<THRESHOLD>::TryRemoveGrandparent(Node* const gp)
+	template<uint THRESHOLD, typename POLICY, typename DERIVED>
+	void QuadTreeElement<THRESHOLD, POLICY, DERIVED>::GetGrandparents(NodeList* const grandparents) const
 	{
-		auto& ref = m_GrandparentCount[gp];
-		ref--;
-
-		// only remove this grandparent if it is now the parent of 0 of our parents
-		if (ref == 0)
+		for (const Parent& parent : m_Parents)
 		{
-			m_GrandparentCount.erase(gp);
-			m_Grandparents.erase(gp);
+			Node* const gp = parent.node->m_Parent;
+			if (!gp || grandparents->Contains(gp))
+				continue;
+
+			// keep the list sorted so that smaller Nodes get merged first
+			uint i = 0;
+			while (i < grandparents->GetSize() && (*grandparents)[i]->m_Dim <= gp->m_Dim)
+				i++;
+			grandparents->Insert(i, gp);
 		}
 	}
 }
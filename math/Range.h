@@ -49,9 +49,10 @@ namespace math
 		}
 		// params.left controls how other.m_Min is evaluated for containment
 		// params.right controls how other.m_Max is evaluated for containment
+		// If other completely surrounds this Range, neither of its endpoints is contained by this one, but they still overlap.
 		bool Overlaps(const Range<T>& other, const RangeOverlapsParams& params = {}) const
 		{
-			return Contains(other.m_Min, params.left) || Contains(other.m_Max, params.right);
+			return Contains(other.m_Min, params.left) || Contains(other.m_Max, params.right) || (other.m_Min < m_Min && m_Max < other.m_Max);
 		}
 		const T& GetMin() const
 		{
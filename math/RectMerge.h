@@ -0,0 +1,135 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include <vector>
+#include "Core.h"
+#include "Vec2.h"
+
+namespace math
+{
+	struct MergedRect
+	{
+		Vec2<float> pos, dim;
+	};
+
+
+	// Merges rects that sit on a shared grid (same size, lined up edge to edge) into fewer, larger rects that cover exactly the same area. It's greedy rather than minimal: scanning row by row, each rect grows as far right as it can, then as far down as its whole width allows. Rects that don't line up with any others of their size are passed through as is, and so are groups so spread out that a grid over them would be mostly empty. Exact duplicates only come out once, whichever way they're handled.
+	static void mergeRects(const std::vector<MergedRect>& rects, std::vector<MergedRect>* const out)
+	{
+		// same size means same grid, anything that's off of it is handled on its own
+		struct DimHash
+		{
+			size_t operator()(const Vec2<float>& v) const
+			{
+				return std::hash<float>()(v.x) ^ (std::hash<float>()(v.y) << 1);
+			}
+		};
+		struct DimEqual
+		{
+			bool operator()(const Vec2<float>& a, const Vec2<float>& b) const
+			{
+				return a.x == b.x && a.y == b.y;
+			}
+		};
+		// in the order each size first shows up, so the output doesn't depend on hashing
+		std::vector<std::pair<Vec2<float>, std::vector<Vec2<float>>>> groups;
+		std::unordered_map<Vec2<float>, uint, DimHash, DimEqual> indices;
+		uint last = 0;
+		for (const MergedRect& rect : rects)
+		{
+			// rects of the same size tend to come in long runs (see Map::AddRect), so skip the lookup for those
+			if (groups.empty() || !DimEqual()(groups[last].first, rect.dim))
+			{
+				const auto [it, added] = indices.insert({ rect.dim, CAST(uint, groups.size()) });
+				if (added)
+					groups.push_back({ rect.dim, {} });
+				last = it->second;
+			}
+			groups[last].second.push_back(rect.pos);
+		}
+
+		std::vector<uint8_t> cells;
+		for (const auto& [dim, positions] : groups)
+		{
+			// find each rect's cell on the grid that the first one is on
+			constexpr float tolerance = 1.f / 1024.f;
+			const Vec2<float> first = positions[0];
+			std::vector<std::pair<int, int>> signedIndices;
+			signedIndices.reserve(positions.size());
+			std::vector<Vec2<float>> offGrid;
+			int minx = 0, miny = 0, maxx = 0, maxy = 0;
+			for (const Vec2<float>& pos : positions)
+			{
+				const float fx = (pos.x - first.x) / dim.x, fy = (pos.y - first.y) / dim.y;
+				const float rx = std::round(fx), ry = std::round(fy);
+				if (abs(fx - rx) > tolerance || abs(fy - ry) > tolerance)
+				{
+					offGrid.push_back(pos);
+					continue;
+				}
+				const int ix = CAST(int, rx), iy = CAST(int, ry);
+				signedIndices.push_back({ ix, iy });
+				minx = min(minx, ix);
+				miny = min(miny, iy);
+				maxx = max(maxx, ix);
+				maxy = max(maxy, iy);
+			}
+
+			// relative to the top left cell
+			const Vec2<float> origin(first.x + minx * dim.x, first.y + miny * dim.y);
+			const uint width = CAST(uint, maxx - minx + 1), height = CAST(uint, maxy - miny + 1);
+			std::vector<std::pair<uint, uint>> cellIndices;
+			cellIndices.reserve(signedIndices.size());
+			for (const auto& [x, y] : signedIndices)
+				cellIndices.push_back({ CAST(uint, x - minx), CAST(uint, y - miny) });
+
+			// anything that isn't merged still only comes out once. Off-grid rects have to match exactly to count as the same.
+			std::sort(offGrid.begin(), offGrid.end(), [](const Vec2<float>& a, const Vec2<float>& b) { return a.y < b.y || (a.y == b.y && a.x < b.x); });
+			offGrid.erase(std::unique(offGrid.begin(), offGrid.end(), [](const Vec2<float>& a, const Vec2<float>& b) { return a.x == b.x && a.y == b.y; }), offGrid.end());
+			for (const Vec2<float>& pos : offGrid)
+				out->push_back({ pos, dim });
+
+			if (CAST(ulong, width) * height > 64ull * cellIndices.size() + 1024)
+			{
+				std::sort(cellIndices.begin(), cellIndices.end(), [](const auto& a, const auto& b) { return a.second < b.second || (a.second == b.second && a.first < b.first); });
+				cellIndices.erase(std::unique(cellIndices.begin(), cellIndices.end()), cellIndices.end());
+				for (const auto& [x, y] : cellIndices)
+					out->push_back({ origin + Vec2<float>(x * dim.x, y * dim.y), dim });
+				continue;
+			}
+
+			cells.assign(CAST(size_t, width) * height, 0);
+			for (const auto& [x, y] : cellIndices)
+				cells[CAST(size_t, y) * width + x] = 1;
+
+			for (uint y = 0; y < height; y++)
+			{
+				for (uint x = 0; x < width; x++)
+				{
+					if (!cells[CAST(size_t, y) * width + x])
+						continue;
+
+					// grow right, then down for as long as every cell in the next row is there
+					uint right = x + 1;
+					while (right < width && cells[CAST(size_t, y) * width + right])
+						right++;
+					uint bottom = y + 1;
+					for (; bottom < height; bottom++)
+					{
+						uint i = x;
+						while (i < right && cells[CAST(size_t, bottom) * width + i])
+							i++;
+						if (i != right)
+							break;
+					}
+
+					for (uint j = y; j < bottom; j++)
+						for (uint i = x; i < right; i++)
+							cells[CAST(size_t, j) * width + i] = 0;
+					out->push_back({ origin + Vec2<float>(x * dim.x, y * dim.y), Vec2<float>((right - x) * dim.x, (bottom - y) * dim.y) });
+				}
+			}
+		}
+	}
+}
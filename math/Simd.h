@@ -0,0 +1,70 @@
+#pragma once
+#include <bit>
+#include "Core.h"
+
+// AVX2 needs /arch:AVX2 (or -mavx2), SSE2 is always there on x64. Define MATH_NO_SIMD to use the scalar version everywhere.
+#if !defined(MATH_NO_SIMD) && defined(__AVX2__)
+#define MATH_SIMD_AVX2
+#include <immintrin.h>
+#elif !defined(MATH_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define MATH_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace math
+{
+	// number of rects that rectOverlapMask tests at once
+#if defined(MATH_SIMD_AVX2)
+	constexpr static uint s_SimdLanes = 8;
+#elif defined(MATH_SIMD_SSE2)
+	constexpr static uint s_SimdLanes = 4;
+#else
+	constexpr static uint s_SimdLanes = 1;
+#endif
+
+
+	// Tests s_SimdLanes rects, stored as four separate arrays of bounds, against the rect [qminx, qmaxx] x [qminy, qmaxy]. Bit i of the result is set if rect i overlaps it, inclusive at the boundaries. All s_SimdLanes entries of each array have to be readable.
+	static uint rectOverlapMask(const float* const minx, const float* const miny, const float* const maxx, const float* const maxy, float qminx, float qminy, float qmaxx, float qmaxy)
+	{
+#if defined(MATH_SIMD_AVX2)
+		const __m256 x = _mm256_and_ps(_mm256_cmp_ps(_mm256_set1_ps(qminx), _mm256_loadu_ps(maxx), _CMP_LE_OQ), _mm256_cmp_ps(_mm256_loadu_ps(minx), _mm256_set1_ps(qmaxx), _CMP_LE_OQ));
+		const __m256 y = _mm256_and_ps(_mm256_cmp_ps(_mm256_set1_ps(qminy), _mm256_loadu_ps(maxy), _CMP_LE_OQ), _mm256_cmp_ps(_mm256_loadu_ps(miny), _mm256_set1_ps(qmaxy), _CMP_LE_OQ));
+		return CAST(uint, _mm256_movemask_ps(_mm256_and_ps(x, y)));
+#elif defined(MATH_SIMD_SSE2)
+		const __m128 x = _mm_and_ps(_mm_cmple_ps(_mm_set1_ps(qminx), _mm_loadu_ps(maxx)), _mm_cmple_ps(_mm_loadu_ps(minx), _mm_set1_ps(qmaxx)));
+		const __m128 y = _mm_and_ps(_mm_cmple_ps(_mm_set1_ps(qminy), _mm_loadu_ps(maxy)), _mm_cmple_ps(_mm_loadu_ps(miny), _mm_set1_ps(qmaxy)));
+		return CAST(uint, _mm_movemask_ps(_mm_and_ps(x, y)));
+#else
+		return CAST(uint, qminx <= *maxx && *minx <= qmaxx && qminy <= *maxy && *miny <= qmaxy);
+#endif
+	}
+	// Tests s_SimdLanes CollisionFilters, stored as separate arrays of categories and masks, against (category, mask). Bit i of the result is set if filter i accepts it, see CollisionFilter::Accepts. All s_SimdLanes entries of each array have to be readable.
+	static uint filterAcceptMask(const uint* const categories, const uint* const masks, uint category, uint mask)
+	{
+#if defined(MATH_SIMD_AVX2)
+		const __m256i zero = _mm256_setzero_si256();
+		const __m256i a = _mm256_and_si256(_mm256_loadu_si256(CAST(const __m256i*, CAST(const void*, categories))), _mm256_set1_epi32(CAST(int, mask)));
+		const __m256i b = _mm256_and_si256(_mm256_loadu_si256(CAST(const __m256i*, CAST(const void*, masks))), _mm256_set1_epi32(CAST(int, category)));
+		const __m256i rejected = _mm256_or_si256(_mm256_cmpeq_epi32(a, zero), _mm256_cmpeq_epi32(b, zero));
+		return ~CAST(uint, _mm256_movemask_ps(_mm256_castsi256_ps(rejected))) & 0xff;
+#elif defined(MATH_SIMD_SSE2)
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i a = _mm_and_si128(_mm_loadu_si128(CAST(const __m128i*, CAST(const void*, categories))), _mm_set1_epi32(CAST(int, mask)));
+		const __m128i b = _mm_and_si128(_mm_loadu_si128(CAST(const __m128i*, CAST(const void*, masks))), _mm_set1_epi32(CAST(int, category)));
+		const __m128i rejected = _mm_or_si128(_mm_cmpeq_epi32(a, zero), _mm_cmpeq_epi32(b, zero));
+		return ~CAST(uint, _mm_movemask_ps(_mm_castsi128_ps(rejected))) & 0xf;
+#else
+		return CAST(uint, (*categories & mask) && (*masks & category));
+#endif
+	}
+	// calls fn(i) for each set bit i of mask, lowest first
+	template<typename FN>
+	static void forEachBit(uint mask, const FN& fn)
+	{
+		while (mask)
+		{
+			fn(CAST(uint, std::countr_zero(mask)));
+			mask &= mask - 1;
+		}
+	}
+}
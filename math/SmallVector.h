@@ -0,0 +1,136 @@
+#pragma once
+#include "Core.h"
+
+namespace math
+{
+	// Array with room for N elements stored inline. It only goes to the heap if it ever needs to hold more than N elements, in which case it doubles its capacity each time it runs out. Meant for small trivially copyable types (pointers, handles, etc.).
+	template<typename T, uint N>
+	class SmallVector
+	{
+	public:
+		SmallVector() :
+			m_Data(m_Inline),
+			m_Size(0),
+			m_Capacity(N)
+		{}
+		SmallVector(const SmallVector& other) = delete;
+		SmallVector(SmallVector&& other) noexcept :
+			m_Data(m_Inline),
+			m_Size(other.m_Size),
+			m_Capacity(N)
+		{
+			// heap storage can just be stolen
+			if (other.IsSpilled())
+			{
+				m_Data = other.m_Data;
+				m_Capacity = other.m_Capacity;
+			}
+			// inline storage has to be copied
+			else
+				for (uint i = 0; i < m_Size; i++)
+					m_Inline[i] = other.m_Inline[i];
+
+			other.m_Data = other.m_Inline;
+			other.m_Size = 0;
+			other.m_Capacity = N;
+		}
+		~SmallVector()
+		{
+			if (IsSpilled())
+				delete[] m_Data;
+		}
+
+
+		T& operator[](uint i)
+		{
+			return m_Data[i];
+		}
+		const T& operator[](uint i) const
+		{
+			return m_Data[i];
+		}
+		T* begin()
+		{
+			return m_Data;
+		}
+		T* end()
+		{
+			return m_Data + m_Size;
+		}
+		const T* begin() const
+		{
+			return m_Data;
+		}
+		const T* end() const
+		{
+			return m_Data + m_Size;
+		}
+		void Push(const T& t)
+		{
+			if (m_Size == m_Capacity)
+				Grow();
+			m_Data[m_Size++] = t;
+		}
+		// insert t at index i, shifting everything after it to the right
+		void Insert(uint i, const T& t)
+		{
+			if (m_Size == m_Capacity)
+				Grow();
+			for (uint j = m_Size; j > i; j--)
+				m_Data[j] = m_Data[j - 1];
+			m_Data[i] = t;
+			m_Size++;
+		}
+		// remove the element at index i by moving the last element into its place. Doesn't preserve order.
+		void Erase(uint i)
+		{
+			m_Data[i] = m_Data[--m_Size];
+		}
+		// index of the first element equal to t, or GetSize() if there isn't one
+		uint Find(const T& t) const
+		{
+			uint i = 0;
+			while (i < m_Size && !(m_Data[i] == t))
+				i++;
+			return i;
+		}
+		bool Contains(const T& t) const
+		{
+			return Find(t) != m_Size;
+		}
+		void Clear()
+		{
+			// keep any heap storage around, if we needed it once we'll probably need it again
+			m_Size = 0;
+		}
+		uint GetSize() const
+		{
+			return m_Size;
+		}
+		bool IsEmpty() const
+		{
+			return m_Size == 0;
+		}
+		// true if this has outgrown its inline storage
+		bool IsSpilled() const
+		{
+			return m_Data != m_Inline;
+		}
+	private:
+		T m_Inline[N];
+		T* m_Data;
+		uint m_Size, m_Capacity;
+
+
+		void Grow()
+		{
+			T* data = new T[m_Capacity * 2];
+			for (uint i = 0; i < m_Size; i++)
+				data[i] = m_Data[i];
+			if (IsSpilled())
+				delete[] m_Data;
+			m_Data = data;
+			m_Capacity *= 2;
+		}
+	};
+}
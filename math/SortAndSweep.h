@@ -0,0 +1,160 @@
+#pragma once
+#include <algorithm>
+#include <vector>
+#include "Core.h"
+#include "Vec2.h"
+#include "CollisionFilter.h"
+
+namespace math
+{
+	// Finds every overlapping pair in a set of Elements (anything with GetPos()/GetDim()/GetFilter()) once per Update. Each Element is an interval on the x axis, and the list of intervals stays sorted between Updates. Things only move a little each frame, so re-sorting it with an insertion sort is close to linear, and a sweep over the sorted list reports each pair exactly once. Pairs whose CollisionFilters don't accept each other are left out.
+	// Elements are registered under a caller-chosen id (less than the capacity), and pairs are reported as ids.
+	template<typename E>
+	class SortAndSweep
+	{
+	public:
+		struct Pair
+		{
+			uint a, b;
+		};
+		struct Stats
+		{
+			uint elements, pairs;
+			// how far intervals had to move in the last insertion sort. Stays around `elements` when the previous order is still a good guess.
+			uint swaps;
+		};
+
+
+		SortAndSweep(uint capacity) :
+			m_Elements(capacity, nullptr),
+			m_Swaps(0)
+		{}
+		SortAndSweep(const SortAndSweep& other) = delete;
+		SortAndSweep(SortAndSweep&& other) = delete;
+
+
+		void Add(E* const e, uint id);
+		void Remove(uint id);
+		// Reads the current bounds of every Element, re-sorts, and rebuilds the pair list. Each Element's bounds are stretched back along its velocity by delta (anything with GetVel()), so that fast ones still get paired with what they passed through during the last step.
+		void Update(float delta = 0.f);
+		// pairs found by the last Update, each one only once
+		const std::vector<Pair>& GetPairs() const
+		{
+			return m_Pairs;
+		}
+		// the Element registered under the given id, or nullptr
+		E* GetElement(uint id) const
+		{
+			return m_Elements[id];
+		}
+		uint GetCapacity() const
+		{
+			return CAST(uint, m_Elements.size());
+		}
+		Stats GetStats() const
+		{
+			return { CAST(uint, m_Intervals.size()), CAST(uint, m_Pairs.size()), m_Swaps };
+		}
+	private:
+		struct Interval
+		{
+			float minx, maxx, miny, maxy;
+			uint id;
+			// copied from the Element each Update, so the sweep never has to leave this list
+			CollisionFilter filter;
+		};
+
+
+		// indexed by id, nullptr for unused ids
+		std::vector<E*> m_Elements;
+		// sorted by minx as of the last Update. New Elements are appended and get sorted in on the next one.
+		std::vector<Interval> m_Intervals;
+		std::vector<Pair> m_Pairs;
+		uint m_Swaps;
+	};
+
+
+
+	template<typename E>
+	void SortAndSweep<E>::Add(E* const e, uint id)
+	{
+		if (id >= m_Elements.size() || m_Elements[id])
+		{
+			printf("Invalid SortAndSweep id %u\n", id);
+			return;
+		}
+
+		m_Elements[id] = e;
+		m_Intervals.push_back({ 0.f, 0.f, 0.f, 0.f, id, {} });
+	}
+	template<typename E>
+	void SortAndSweep<E>::Remove(uint id)
+	{
+		if (id >= m_Elements.size() || !m_Elements[id])
+			return;
+
+		m_Elements[id] = nullptr;
+		// erase rather than swap so that the rest stays sorted
+		for (uint i = 0; i < m_Intervals.size(); i++)
+		{
+			if (m_Intervals[i].id == id)
+			{
+				m_Intervals.erase(m_Intervals.begin() + i);
+				break;
+			}
+		}
+
+		// anything paired with this is stale until the next Update
+		m_Pairs.erase(std::remove_if(m_Pairs.begin(), m_Pairs.end(), [id](const Pair& p) { return p.a == id || p.b == id; }), m_Pairs.end());
+	}
+	template<typename E>
+	void SortAndSweep<E>::Update(float delta)
+	{
+		for (Interval& interval : m_Intervals)
+		{
+			const E* const e = m_Elements[interval.id];
+			const Vec2<float>& pos = e->GetPos(), & dim = e->GetDim();
+			interval.minx = pos.x;
+			interval.maxx = pos.x + dim.x;
+			interval.miny = pos.y;
+			interval.maxy = pos.y + dim.y;
+			interval.filter = e->GetFilter();
+			if (delta != 0.f)
+			{
+				const Vec2<float> back = e->GetVel() * -delta;
+				interval.minx += min(back.x, 0.f);
+				interval.maxx += max(back.x, 0.f);
+				interval.miny += min(back.y, 0.f);
+				interval.maxy += max(back.y, 0.f);
+			}
+		}
+
+		// insertion sort by minx, starting from last frame's order
+		m_Swaps = 0;
+		for (uint i = 1; i < m_Intervals.size(); i++)
+		{
+			const Interval cur = m_Intervals[i];
+			uint j = i;
+			while (j > 0 && m_Intervals[j - 1].minx > cur.minx)
+			{
+				m_Intervals[j] = m_Intervals[j - 1];
+				j--;
+			}
+			m_Intervals[j] = cur;
+			m_Swaps += i - j;
+		}
+
+		// Everything that can overlap interval i on the x axis starts after it in the list, and before i ends. So each pair is only found from its leftmost member. Bounds are inclusive, like Hitbox.
+		m_Pairs.clear();
+		for (uint i = 0; i < m_Intervals.size(); i++)
+		{
+			const Interval& a = m_Intervals[i];
+			for (uint j = i + 1; j < m_Intervals.size() && m_Intervals[j].minx <= a.maxx; j++)
+			{
+				const Interval& b = m_Intervals[j];
+				if (a.miny <= b.maxy && b.miny <= a.maxy && a.filter.Accepts(b.filter))
+					m_Pairs.push_back({ a.id, b.id });
+			}
+		}
+	}
+}
@@ -0,0 +1,438 @@
+#pragma once
+#include <type_traits>
+#include <vector>
+#include "Core.h"
+#include "Vec2.h"
+#include "SmallVector.h"
+#include "StaticGrid.h"
+#include "Ray.h"
+#include "CollisionElement.h"
+
+namespace math
+{
+	/**
+	 * SpatialHash.h
+	 */
+
+	// see QuadTreeElement for DERIVED
+	template<uint CELL, typename DERIVED = void>
+	class SpatialHashElement;
+
+	// Drop-in alternative to QuadTreeNode for content that's roughly uniform in size. Space is cut into CELL x CELL cells, each cell is hashed into a fixed table of buckets, and each bucket is a small list of Elements. Nothing ever divides or merges, and an Element only touches the table when it crosses into a different set of cells.
+	template<uint CELL, typename DERIVED = void>
+	class SpatialHash
+	{
+	public:
+		typedef SpatialHash<CELL, DERIVED> Node;
+		typedef SpatialHashElement<CELL, DERIVED> Element;
+		typedef StaticGrid<Element> Statics;
+		friend class SpatialHashElement<CELL, DERIVED>;
+
+
+		struct Stats
+		{
+			// number of buckets, and how many of them have anything in them
+			uint buckets, bucketsUsed;
+			// number of Elements, and total number of bucket entries they take up
+			uint elements, entries;
+			// number of Move calls that changed position/size, and how many of those crossed into a different set of cells
+			uint moves, cellChanges;
+		};
+
+
+		SpatialHash(const math::Vec2<float>& min, const math::Vec2<float>& max);
+		SpatialHash(const Node& other) = delete;
+		SpatialHash(Node&& other) = delete;
+		~SpatialHash();
+
+
+		void Add(Element* e);
+		// see QuadTreeNode::Build. There's no structure to build here, so it's just Add.
+		void Build(Element* const* const elements, uint count)
+		{
+			for (uint i = 0; i < count; i++)
+				Add(elements[i]);
+		}
+		void Remove(Element* e);
+		// see QuadTreeNode::SetDeferredMerges/EndFrame. Nothing to do, buckets only ever change in Move.
+		void SetDeferredMerges(bool deferred) {}
+		void EndFrame() {}
+		// see QuadTreeNode::SetStatics
+		void SetStatics(const Statics* const statics)
+		{
+			m_Statics = statics;
+		}
+		// same as the QuadTreeNode queries
+		uint QueryAABB(const math::Vec2<float>& pos, const math::Vec2<float>& dim, Element** const out, uint capacity) const;
+		uint QueryPoint(const math::Vec2<float>& point, Element** const out, uint capacity) const;
+		uint QueryRay(const math::Ray<float>& ray, Element** const out, float* const times, uint capacity) const;
+		const math::Vec2<float>& GetPos() const
+		{
+			return m_Pos;
+		}
+		uint GetDim() const
+		{
+			return m_Dim;
+		}
+		Stats GetStats() const;
+	private:
+		// range of cells covered by something, inclusive on both ends
+		struct Cells
+		{
+			int x0, y0, x1, y1;
+
+
+			bool operator==(const Cells& other) const
+			{
+				return x0 == other.x0 && y0 == other.y0 && x1 == other.x1 && y1 == other.y1;
+			}
+			bool Overlaps(const Cells& other) const
+			{
+				return x0 <= other.x1 && other.x0 <= x1 && y0 <= other.y1 && other.y0 <= y1;
+			}
+		};
+		// almost every Element is in at most 4 cells, which almost never land in the same bucket
+		constexpr static uint s_InlineBucket = 4, s_MaxBuckets = 1 << 16;
+		typedef SmallVector<Element*, s_InlineBucket> Bucket;
+		typedef SmallVector<uint, s_InlineBucket> BucketList;
+
+
+		// (x, y) of bottom left corner and side length of the area the hash was made for. It's only used to size the table and for IsContainedBy, Elements outside of it still work.
+		math::Vec2<float> m_Pos;
+		uint m_Dim;
+		std::vector<Bucket> m_Buckets;
+		// number of buckets - 1 (it's always a power of 2)
+		uint m_Mask;
+		uint m_Count, m_Moves, m_CellChanges;
+		const Statics* m_Statics;
+
+
+		static int CellOf(float f)
+		{
+			return CAST(int, std::floor(f / CELL));
+		}
+		static Cells CellsOf(const math::Vec2<float>& pos, const math::Vec2<float>& dim)
+		{
+			return { CellOf(pos.x), CellOf(pos.y), CellOf(pos.x + dim.x), CellOf(pos.y + dim.y) };
+		}
+		uint Hash(int x, int y) const
+		{
+			return (CAST(uint, x) * 73856093u ^ CAST(uint, y) * 19349663u) & m_Mask;
+		}
+		// unique buckets that the given cells hash to
+		void GetBuckets(const Cells& cells, BucketList* const buckets) const;
+		void Insert(Element* e, const BucketList& buckets);
+		void Erase(Element* e, const BucketList& buckets);
+		// Calls fn(Element*) once for each Element whose cells overlap the given ones, as long as filter(Element*) is true. An Element is in every bucket its cells hash to, so it's only reported from the cell in the bottom left corner of the overlap between its cells and the given ones.
+		template<typename FILTER, typename FN>
+		void ForEachInCells(const Cells& cells, const FILTER& filter, const FN& fn) const;
+	};
+
+
+	/**
+	 * SpatialHashElement.h
+	 */
+	template<uint CELL, typename DERIVED>
+	class SpatialHashElement : public CollisionElement<SpatialHashElement<CELL, DERIVED>, DERIVED>
+	{
+	protected:
+		typedef SpatialHash<CELL, DERIVED> Node;
+		typedef SpatialHashElement<CELL, DERIVED> Element;
+		typedef CollisionElement<Element, DERIVED> Collider;
+		friend class SpatialHash<CELL, DERIVED>;
+		friend Collider;
+
+
+	public:
+		SpatialHashElement(const math::Vec2<float>& pos, const math::Vec2<float>& dim, const math::Vec2<float>& vel);
+		SpatialHashElement(const Element& other) = delete;
+		SpatialHashElement(Element&& other) noexcept;
+		virtual ~SpatialHashElement()
+		{
+			// the buckets hold on to us by address
+			Delete();
+		}
+
+
+		using Collider::Update;
+		void Move(const math::Vec2<float>& pos, const math::Vec2<float>& dim, const math::Vec2<float>& vel, Node* const root);
+		void Update(float delta);
+	protected:
+		using Collider::m_Pos;
+		using Collider::m_Dim;
+		using Collider::CopyHostValues;
+		using Collider::Collide;
+		// hash that contains this Element, and the cells we're registered in. Those only change in Move, so they can lag behind m_Pos after ResolveCollision until the next Move.
+		Node* m_Hash;
+		typename Node::Cells m_Cells;
+
+
+		virtual bool IsContainedBy(const Node* const node) const = 0;
+		// IsContainedBy, called on DERIVED directly if there is one (see CollisionElement::CallIntersects)
+		bool CallIsContainedBy(const Node* const node) const
+		{
+			if constexpr (std::is_void_v<DERIVED>)
+				return IsContainedBy(node);
+			else
+				return CAST(const DERIVED*, this)->DERIVED::IsContainedBy(node);
+		}
+		// for CollisionElement::Gather
+		const typename Node::Statics* GetStatics() const
+		{
+			return m_Hash ? m_Hash->m_Statics : nullptr;
+		}
+		void Delete()
+		{
+			if (m_Hash)
+				m_Hash->Remove(this);
+		}
+	};
+
+
+	/**
+	 * SpatialHash.cpp
+	 */
+	template<uint CELL, typename DERIVED>
+	SpatialHash<CELL, DERIVED>::SpatialHash(const math::Vec2<float>& min, const math::Vec2<float>& max) :
+		m_Pos(min),
+		m_Dim(0),
+		m_Mask(0),
+		m_Count(0),
+		m_Moves(0),
+		m_CellChanges(0),
+		m_Statics(nullptr)
+	{
+		const Vec2<float> diff = max - min;
+		m_Dim = nextPower(2, math::max(diff.x, diff.y));
+
+		// about one bucket per cell in the given area, so that a full area rarely puts two cells in the same bucket
+		const uint side = m_Dim / CELL + 1;
+		const uint buckets = math::min(nextPower(2u, side * side), s_MaxBuckets);
+		m_Buckets = std::vector<Bucket>(buckets);
+		m_Mask = buckets - 1;
+	}
+	template<uint CELL, typename DERIVED>
+	SpatialHash<CELL, DERIVED>::~SpatialHash()
+	{
+		// Elements can outlive the hash. Each one is in at least one bucket.
+		for (Bucket& bucket : m_Buckets)
+			for (Element* e : bucket)
+				e->m_Hash = nullptr;
+	}
+	template<uint CELL, typename DERIVED>
+	void SpatialHash<CELL, DERIVED>::Add(Element* e)
+	{
+		if (e->m_Hash)
+			return;
+
+		if (!e->CallIsContainedBy(this))
+		{
+			const auto& pos = e->m_Pos, dim = e->m_Dim;
+			printf("SpatialHash [(%f, %f), (%f, %f)] cannot contain element [(%f, %f), (%f, %f)]\n", m_Pos.x, m_Pos.y, m_Pos.x + m_Dim, m_Pos.y + m_Dim, pos.x, pos.y, pos.x + dim.x, pos.y + dim.y);
+			return;
+		}
+
+		e->m_Hash = this;
+		e->m_Cells = CellsOf(e->m_Pos, e->m_Dim);
+		BucketList buckets;
+		GetBuckets(e->m_Cells, &buckets);
+		Insert(e, buckets);
+		m_Count++;
+	}
+	template<uint CELL, typename DERIVED>
+	void SpatialHash<CELL, DERIVED>::Remove(Element* e)
+	{
+		if (e->m_Hash != this)
+			return;
+
+		BucketList buckets;
+		GetBuckets(e->m_Cells, &buckets);
+		Erase(e, buckets);
+		e->m_Hash = nullptr;
+		m_Count--;
+	}
+	template<uint CELL, typename DERIVED>
+	typename SpatialHash<CELL, DERIVED>::Stats SpatialHash<CELL, DERIVED>::GetStats() const
+	{
+		uint used = 0, entries = 0;
+		for (const Bucket& bucket : m_Buckets)
+		{
+			used += !bucket.IsEmpty();
+			entries += bucket.GetSize();
+		}
+		return { CAST(uint, m_Buckets.size()), used, m_Count, entries, m_Moves, m_CellChanges };
+	}
+	template<uint CELL, typename DERIVED>
+	void SpatialHash<CELL, DERIVED>::GetBuckets(const Cells& cells, BucketList* const buckets) const
+	{
+		for (int y = cells.y0; y <= cells.y1; y++)
+		{
+			for (int x = cells.x0; x <= cells.x1; x++)
+			{
+				const uint b = Hash(x, y);
+				if (!buckets->Contains(b))
+					buckets->Push(b);
+			}
+		}
+	}
+	template<uint CELL, typename DERIVED>
+	void SpatialHash<CELL, DERIVED>::Insert(Element* e, const BucketList& buckets)
+	{
+		for (const uint b : buckets)
+			m_Buckets[b].Push(e);
+	}
+	template<uint CELL, typename DERIVED>
+	void SpatialHash<CELL, DERIVED>::Erase(Element* e, const BucketList& buckets)
+	{
+		for (const uint b : buckets)
+		{
+			Bucket& bucket = m_Buckets[b];
+			const uint i = bucket.Find(e);
+			if (i != bucket.GetSize())
+				bucket.Erase(i);
+		}
+	}
+	template<uint CELL, typename DERIVED>
+	template<typename FILTER, typename FN>
+	void SpatialHash<CELL, DERIVED>::ForEachInCells(const Cells& cells, const FILTER& filter, const FN& fn) const
+	{
+		for (int y = cells.y0; y <= cells.y1; y++)
+		{
+			for (int x = cells.x0; x <= cells.x1; x++)
+			{
+				for (Element* const e : m_Buckets[Hash(x, y)])
+				{
+					// Buckets are shared by unrelated cells, so this might not be in (x, y) at all. If it is, only report it from one cell.
+					const Cells& ec = e->m_Cells;
+					if (ec.Overlaps(cells) && math::max(ec.x0, cells.x0) == x && math::max(ec.y0, cells.y0) == y && filter(e))
+						fn(e);
+				}
+			}
+		}
+	}
+	template<uint CELL, typename DERIVED>
+	uint SpatialHash<CELL, DERIVED>::QueryAABB(const math::Vec2<float>& pos, const math::Vec2<float>& dim, Element** const out, uint capacity) const
+	{
+		uint count = 0;
+		ForEachInCells(CellsOf(pos, dim),
+			[&](const Element* const e)
+			{
+				const auto& ep = e->m_Pos, ed = e->m_Dim;
+				return count < capacity && pos.x <= ep.x + ed.x && ep.x <= pos.x + dim.x && pos.y <= ep.y + ed.y && ep.y <= pos.y + dim.y;
+			},
+			[&](Element* const e) { out[count++] = e; });
+		return count + (m_Statics ? m_Statics->QueryAABB(pos, dim, out + count, capacity - count) : 0);
+	}
+	template<uint CELL, typename DERIVED>
+	uint SpatialHash<CELL, DERIVED>::QueryPoint(const math::Vec2<float>& point, Element** const out, uint capacity) const
+	{
+		return QueryAABB(point, { 0.f, 0.f }, out, capacity);
+	}
+	template<uint CELL, typename DERIVED>
+	uint SpatialHash<CELL, DERIVED>::QueryRay(const math::Ray<float>& ray, Element** const out, float* const times, uint capacity) const
+	{
+		// search every cell touched by the segment's bounding box
+		const Vec2<float> end = ray.origin + ray.direction;
+		const Vec2<float> min = { math::min(ray.origin.x, end.x), math::min(ray.origin.y, end.y) };
+		const Vec2<float> max = { math::max(ray.origin.x, end.x), math::max(ray.origin.y, end.y) };
+
+		// IntersectsRect isn't const
+		math::Ray<float> r = ray;
+		uint count = 0;
+		float time = 0.f;
+		ForEachInCells(CellsOf(min, max - min),
+			[&](const Element* const e) { return count < capacity && r.IntersectsRect(e->m_Pos, e->m_Dim, nullptr, nullptr, &time); },
+			[&](Element* const e)
+			{
+				if (times)
+					times[count] = time;
+				out[count++] = e;
+			});
+		return count + (m_Statics ? m_Statics->QueryRay(ray, out + count, times ? times + count : nullptr, capacity - count) : 0);
+	}
+
+
+
+	/**
+	 * SpatialHashElement.cpp
+	 */
+	template<uint CELL, typename DERIVED>
+	SpatialHashElement<CELL, DERIVED>::SpatialHashElement(const math::Vec2<float>& pos, const math::Vec2<float>& dim, const math::Vec2<float>& vel) :
+		Collider(pos, dim, vel),
+		m_Hash(nullptr),
+		m_Cells{ 0, 0, 0, 0 }
+	{}
+	template<uint CELL, typename DERIVED>
+	SpatialHashElement<CELL, DERIVED>::SpatialHashElement(Element&& other) noexcept :
+		Collider(std::move(other)),
+		m_Hash(nullptr),
+		m_Cells(other.m_Cells)
+	{
+		// take other's place in the hash
+		if (other.m_Hash)
+		{
+			m_Hash = other.m_Hash;
+			typename Node::BucketList buckets;
+			m_Hash->GetBuckets(m_Cells, &buckets);
+			m_Hash->Erase(&other, buckets);
+			m_Hash->Insert(this, buckets);
+			other.m_Hash = nullptr;
+		}
+	}
+	template<uint CELL, typename DERIVED>
+	void SpatialHashElement<CELL, DERIVED>::Move(const math::Vec2<float>& pos, const math::Vec2<float>& dim, const math::Vec2<float>& vel, Node* const root)
+	{
+		// if position of dimensions have changed, we might be in different cells now
+		if (m_Pos != pos || m_Dim != dim)
+		{
+			CopyHostValues(pos, dim, vel);
+
+			if (!m_Hash)
+			{
+				root->Add(this);
+				return;
+			}
+
+			m_Hash->m_Moves++;
+			const typename Node::Cells cells = Node::CellsOf(m_Pos, m_Dim);
+			// most common case by far: we moved a bit but we're still in the same cells
+			if (cells == m_Cells)
+				return;
+			m_Hash->m_CellChanges++;
+
+			// only touch the buckets that actually changed
+			typename Node::BucketList before, after;
+			m_Hash->GetBuckets(m_Cells, &before);
+			m_Hash->GetBuckets(cells, &after);
+			for (uint i = 0; i < before.GetSize();)
+			{
+				const uint j = after.Find(before[i]);
+				if (j != after.GetSize())
+				{
+					before.Erase(i);
+					after.Erase(j);
+				}
+				else
+					i++;
+			}
+			m_Hash->Erase(this, before);
+			m_Hash->Insert(this, after);
+			m_Cells = cells;
+		}
+		// we haven't moved or changed size, so our cells don't need to change
+		else
+			CopyHostValues(pos, dim, vel);
+	}
+	template<uint CELL, typename DERIVED>
+	void SpatialHashElement<CELL, DERIVED>::Update(float delta)
+	{
+		// we aren't in a hash, so there's nothing to check against
+		if (!m_Hash)
+			return;
+
+		Collide(delta, [this](const auto& mark, const auto&)
+			{
+				m_Hash->ForEachInCells(m_Cells, [this](const Element* const cur) { return cur != this; }, mark);
+			});
+	}
+}
@@ -0,0 +1,223 @@
+#pragma once
+#include <limits>
+#include <vector>
+#include "Core.h"
+#include "Vec2.h"
+#include "Ray.h"
+#include "Simd.h"
+#include "CollisionFilter.h"
+
+namespace math
+{
+	// Read-only uniform grid over a fixed set of Elements (anything with GetPos()/GetDim()/GetFilter()). It's built once and stored in a few contiguous arrays: for each cell, a range into one packed list of Element indices (and their bounds), so a query is a linear scan over a handful of cells. That scan tests s_SimdLanes bounds at a time, see rectOverlapMask.
+	template<typename E>
+	class StaticGrid
+	{
+	public:
+		StaticGrid(E* const* const elements, uint count);
+		StaticGrid(const StaticGrid& other) = delete;
+		StaticGrid(StaticGrid&& other) = delete;
+
+
+		// Calls fn(E*) once for each Element whose rect overlaps the given rect (inclusive at the boundaries)
+		template<typename FN>
+		void Query(const Vec2<float>& pos, const Vec2<float>& dim, const FN& fn) const
+		{
+			Scan<false>(pos, dim, {}, fn);
+		}
+		// Query, but only for Elements whose filter accepts the given one. That's tested alongside the bounds, so rejected Elements cost nothing extra.
+		template<typename FN>
+		void Query(const Vec2<float>& pos, const Vec2<float>& dim, const CollisionFilter& filter, const FN& fn) const
+		{
+			Scan<true>(pos, dim, filter, fn);
+		}
+		// Query over the whole area a rect covers while moving by `motion`, so nothing it passes through gets missed
+		template<typename FN>
+		void QuerySwept(const Vec2<float>& pos, const Vec2<float>& dim, const Vec2<float>& motion, const CollisionFilter& filter, const FN& fn) const
+		{
+			const Vec2<float> offset(min(motion.x, 0.f), min(motion.y, 0.f));
+			Query(pos + offset, dim + motion.Abs(), filter, fn);
+		}
+		// Elements whose rect overlaps the given rect. Writes up to `capacity` of them into `out` and returns how many it wrote.
+		uint QueryAABB(const Vec2<float>& pos, const Vec2<float>& dim, E** const out, uint capacity) const
+		{
+			uint count = 0;
+			Query(pos, dim, [&](E* const e) { if (count < capacity) out[count++] = e; });
+			return count;
+		}
+		// Elements hit by the segment from ray.origin to ray.origin + ray.direction, as defined by Ray::IntersectsRect
+		uint QueryRay(const Ray<float>& ray, E** const out, float* const times, uint capacity) const;
+		uint GetCount() const
+		{
+			return CAST(uint, m_Elements.size());
+		}
+		uint GetCellCount() const
+		{
+			return m_Width * m_Height;
+		}
+	private:
+		// the grid never has more than this many cells per Element
+		constexpr static uint s_MaxCellsPerElement = 4;
+		// bottom left corner of the grid
+		Vec2<float> m_Pos;
+		float m_CellSize;
+		uint m_Width, m_Height;
+		std::vector<E*> m_Elements;
+		// m_CellStart[c] to m_CellStart[c + 1] is the range of m_Items (and m_ItemBounds) that belongs to cell c
+		std::vector<uint> m_CellStart;
+		// index into m_Elements for each entry, sorted by cell
+		std::vector<uint> m_Items;
+		// bounds of each entry in m_Items, copied so that a cell can be scanned without touching the Elements themselves. Each one is its own array so that they can be loaded s_SimdLanes at a time, and they're padded with bounds that never overlap anything so that a load at the end of the last cell stays in range.
+		std::vector<float> m_MinX, m_MinY, m_MaxX, m_MaxY;
+		// same for each entry's CollisionFilter, padded with filters that never accept anything
+		std::vector<uint> m_Categories, m_Masks;
+
+
+		// Query, skipping entries that filter doesn't accept if FILTERED
+		template<bool FILTERED, typename FN>
+		void Scan(const Vec2<float>& pos, const Vec2<float>& dim, const CollisionFilter& filter, const FN& fn) const;
+		uint CellX(float x) const
+		{
+			return CAST(uint, clamp((x - m_Pos.x) / m_CellSize, 0.f, m_Width - 1.f));
+		}
+		uint CellY(float y) const
+		{
+			return CAST(uint, clamp((y - m_Pos.y) / m_CellSize, 0.f, m_Height - 1.f));
+		}
+	};
+
+
+
+	template<typename E>
+	StaticGrid<E>::StaticGrid(E* const* const elements, uint count) :
+		m_Pos(0.f, 0.f),
+		m_CellSize(1.f),
+		m_Width(1),
+		m_Height(1),
+		m_Elements(elements, elements + count)
+	{
+		m_CellStart.assign(2, 0);
+		if (count == 0)
+			return;
+
+		// bounds of the whole set, and the average size of an Element
+		constexpr float fmax = std::numeric_limits<float>::max(), fmin = std::numeric_limits<float>::lowest();
+		Vec2<float> min = { fmax, fmax }, max = { fmin, fmin };
+		float average = 0.f;
+		for (E* const e : m_Elements)
+		{
+			const Vec2<float>& pos = e->GetPos(), & dim = e->GetDim();
+			min.x = math::min(min.x, pos.x);
+			min.y = math::min(min.y, pos.y);
+			max.x = math::max(max.x, pos.x + dim.x);
+			max.y = math::max(max.y, pos.y + dim.y);
+			average += math::max(dim.x, dim.y);
+		}
+		average /= count;
+
+		// cells twice the size of an average Element, so most Elements land in a single cell. Sparse sets get bigger cells so that the grid can't have many more cells than Elements.
+		const Vec2<float> extent = max - min;
+		m_CellSize = math::max(2.f * average, 1.f);
+		while ((extent.x / m_CellSize + 1.f) * (extent.y / m_CellSize + 1.f) > s_MaxCellsPerElement * count)
+			m_CellSize *= 2.f;
+		m_Pos = min;
+		m_Width = CAST(uint, extent.x / m_CellSize) + 1;
+		m_Height = CAST(uint, extent.y / m_CellSize) + 1;
+
+		// counting sort of Elements into cells. First pass counts the entries in each cell...
+		m_CellStart.assign(m_Width * m_Height + 1, 0);
+		for (E* const e : m_Elements)
+		{
+			const Vec2<float>& pos = e->GetPos(), & dim = e->GetDim();
+			for (uint y = CellY(pos.y); y <= CellY(pos.y + dim.y); y++)
+				for (uint x = CellX(pos.x); x <= CellX(pos.x + dim.x); x++)
+					m_CellStart[y * m_Width + x + 1]++;
+		}
+		// ...which turns into a start index for each cell...
+		for (uint i = 1; i < m_CellStart.size(); i++)
+			m_CellStart[i] += m_CellStart[i - 1];
+		// ...and the second pass fills them in
+		std::vector<uint> next(m_CellStart.begin(), m_CellStart.end() - 1);
+		const uint entries = m_CellStart.back();
+		m_Items.resize(entries);
+		m_MinX.resize(entries + s_SimdLanes, fmax);
+		m_MinY.resize(entries + s_SimdLanes, fmax);
+		m_MaxX.resize(entries + s_SimdLanes, fmin);
+		m_MaxY.resize(entries + s_SimdLanes, fmin);
+		m_Categories.resize(entries + s_SimdLanes, 0);
+		m_Masks.resize(entries + s_SimdLanes, 0);
+		for (uint i = 0; i < count; i++)
+		{
+			const Vec2<float>& pos = m_Elements[i]->GetPos(), & dim = m_Elements[i]->GetDim();
+			const CollisionFilter& filter = m_Elements[i]->GetFilter();
+			for (uint y = CellY(pos.y); y <= CellY(pos.y + dim.y); y++)
+			{
+				for (uint x = CellX(pos.x); x <= CellX(pos.x + dim.x); x++)
+				{
+					const uint slot = next[y * m_Width + x]++;
+					m_Items[slot] = i;
+					m_MinX[slot] = pos.x;
+					m_MinY[slot] = pos.y;
+					m_MaxX[slot] = pos.x + dim.x;
+					m_MaxY[slot] = pos.y + dim.y;
+					m_Categories[slot] = filter.category;
+					m_Masks[slot] = filter.mask;
+				}
+			}
+		}
+	}
+	template<typename E>
+	template<bool FILTERED, typename FN>
+	void StaticGrid<E>::Scan(const Vec2<float>& pos, const Vec2<float>& dim, const CollisionFilter& filter, const FN& fn) const
+	{
+		const float qminx = pos.x, qminy = pos.y, qmaxx = pos.x + dim.x, qmaxy = pos.y + dim.y;
+		const uint x0 = CellX(qminx), x1 = CellX(qmaxx), y0 = CellY(qminy), y1 = CellY(qmaxy);
+
+		for (uint y = y0; y <= y1; y++)
+		{
+			for (uint x = x0; x <= x1; x++)
+			{
+				const uint cell = y * m_Width + x, end = m_CellStart[cell + 1];
+				for (uint i = m_CellStart[cell]; i < end; i += s_SimdLanes)
+				{
+					uint mask = rectOverlapMask(&m_MinX[i], &m_MinY[i], &m_MaxX[i], &m_MaxY[i], qminx, qminy, qmaxx, qmaxy);
+					if constexpr (FILTERED)
+						mask &= filterAcceptMask(&m_Categories[i], &m_Masks[i], filter.category, filter.mask);
+					// lanes past the end of this cell belong to the next one
+					if (end - i < s_SimdLanes)
+						mask &= (1u << (end - i)) - 1;
+
+					forEachBit(mask, [&](uint lane)
+						{
+							// An Element that spans several cells is in each of their lists. Only report it from the cell that holds the bottom left corner of its overlap with the query, which is a cell that both of them always touch.
+							const uint j = i + lane;
+							if (CellX(max(qminx, m_MinX[j])) == x && CellY(max(qminy, m_MinY[j])) == y)
+								fn(m_Elements[m_Items[j]]);
+						});
+				}
+			}
+		}
+	}
+	template<typename E>
+	uint StaticGrid<E>::QueryRay(const Ray<float>& ray, E** const out, float* const times, uint capacity) const
+	{
+		// search every cell touched by the segment's bounding box
+		const Vec2<float> end = ray.origin + ray.direction;
+		const Vec2<float> min = { math::min(ray.origin.x, end.x), math::min(ray.origin.y, end.y) };
+		const Vec2<float> max = { math::max(ray.origin.x, end.x), math::max(ray.origin.y, end.y) };
+
+		// IntersectsRect isn't const
+		Ray<float> r = ray;
+		uint count = 0;
+		Query(min, max - min, [&](E* const e)
+			{
+				float time = 0.f;
+				if (count == capacity || !r.IntersectsRect(e->GetPos(), e->GetDim(), nullptr, nullptr, &time))
+					return;
+				if (times)
+					times[count] = time;
+				out[count++] = e;
+			});
+		return count;
+	}
+}
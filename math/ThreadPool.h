@@ -0,0 +1,110 @@
+#pragma once
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Core.h"
+
+namespace math
+{
+	// Fixed set of worker threads for splitting a loop across cores. The threads are started once and sleep between calls to For, so it's cheap enough to use every frame. The calling thread does its share of the work too.
+	class ThreadPool
+	{
+	public:
+		// threads includes the calling thread, so 1 doesn't start any workers
+		ThreadPool(uint threads) :
+			m_Fn(nullptr),
+			m_Call(nullptr),
+			m_Count(0),
+			m_Generation(0),
+			m_Remaining(0),
+			m_Quit(false)
+		{
+			for (uint i = 1; i < max(threads, 1u); i++)
+				m_Workers.emplace_back(&ThreadPool::Work, this, i);
+		}
+		ThreadPool(const ThreadPool& other) = delete;
+		ThreadPool(ThreadPool&& other) = delete;
+		~ThreadPool()
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_Mutex);
+				m_Quit = true;
+			}
+			m_Start.notify_all();
+			for (std::thread& worker : m_Workers)
+				worker.join();
+		}
+
+
+		// Splits [0, count) into GetThreadCount() contiguous ranges and calls fn(thread, begin, end) for each one, where thread is in [0, GetThreadCount()). Returns once they're all done. Range i always goes to the same thread index, so per-thread buffers can be indexed by it.
+		template<typename FN>
+		void For(uint count, const FN& fn)
+		{
+			if (m_Workers.empty())
+			{
+				fn(0u, 0u, count);
+				return;
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(m_Mutex);
+				m_Fn = &fn;
+				m_Call = [](const void* const f, uint thread, uint begin, uint end) { (*CAST(const FN*, f))(thread, begin, end); };
+				m_Count = count;
+				m_Remaining = CAST(uint, m_Workers.size());
+				m_Generation++;
+			}
+			m_Start.notify_all();
+
+			const auto [begin, end] = GetRange(0);
+			fn(0u, begin, end);
+
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_Done.wait(lock, [this]() { return m_Remaining == 0; });
+		}
+		uint GetThreadCount() const
+		{
+			return CAST(uint, m_Workers.size()) + 1;
+		}
+	private:
+		std::vector<std::thread> m_Workers;
+		std::mutex m_Mutex;
+		std::condition_variable m_Start, m_Done;
+		// the current For's fn, and how to call it without knowing its type
+		const void* m_Fn;
+		void (*m_Call)(const void* const, uint, uint, uint);
+		uint m_Count;
+		// bumped by each For so that the workers know there's something new to do
+		ulong m_Generation;
+		uint m_Remaining;
+		bool m_Quit;
+
+
+		std::pair<uint, uint> GetRange(uint thread) const
+		{
+			const ulong threads = GetThreadCount(), count = m_Count;
+			return { CAST(uint, count * thread / threads), CAST(uint, count * (thread + 1) / threads) };
+		}
+		void Work(uint thread)
+		{
+			ulong seen = 0;
+			while (true)
+			{
+				std::unique_lock<std::mutex> lock(m_Mutex);
+				m_Start.wait(lock, [&]() { return m_Quit || m_Generation != seen; });
+				if (m_Quit)
+					return;
+				seen = m_Generation;
+				const auto [begin, end] = GetRange(thread);
+				lock.unlock();
+
+				m_Call(m_Fn, thread, begin, end);
+
+				lock.lock();
+				if (--m_Remaining == 0)
+					m_Done.notify_one();
+			}
+		}
+	};
+}
@@ -6,7 +6,49 @@ namespace engine
 	constexpr static uint s_IndexOffsets[s_IndicesPerQuad] = { 0, 1, 2, 0, 2, 3 };
 	constexpr static float s_CornerPoints[] = { 0.f, 0.f, 1.f, 0.f, 1.f, 1.f, 0.f, 1.f };
 	constexpr static uint s_QuadTreeThreshold = 4;
-	typedef math::QuadTreeNode<s_QuadTreeThreshold> QTNode;
+	// math::QuadTreeStrict or math::QuadTreeLoose
+	typedef math::QuadTreeStrict QTPolicy;
+	// side length of a math::SpatialHash cell (in simulated pixels)
+	constexpr static uint s_SpatialHashCellDim = 16;
+	// which structure dynamic Hitboxes (and Chunks) use to find collisions. QTPolicy only applies to QUAD_TREE.
+	enum class Broadphase
+	{
+		QUAD_TREE, LINEAR_QUAD_TREE, SPATIAL_HASH
+	};
+	constexpr static Broadphase s_Broadphase = Broadphase::QUAD_TREE;
+	// QUAD_TREE only, see math::QuadTreeNode::SetDeferredMerges
+	constexpr static bool s_DeferredQuadTreeMerges = true;
+	// if true, QTNode's Elements call Hitbox's collision functions directly instead of through the vtable (see math::QuadTreeElement), so they can be inlined. Hitbox has to be the only class derived from QTNode::Element.
+	constexpr static bool s_StaticElementDispatch = true;
+	class Hitbox;
+	typedef std::conditional_t<s_StaticElementDispatch, Hitbox, void> QTDerived;
+	// the broadphase that s_Broadphase picks, for Elements with the given DERIVED
+	template<typename DERIVED>
+	using QTNodeOf = std::conditional_t<s_Broadphase == Broadphase::SPATIAL_HASH, math::SpatialHash<s_SpatialHashCellDim, DERIVED>,
+		std::conditional_t<s_Broadphase == Broadphase::LINEAR_QUAD_TREE, math::LinearQuadTree<s_QuadTreeThreshold, DERIVED>, math::QuadTreeNode<s_QuadTreeThreshold, QTPolicy, DERIVED>>>;
+	typedef QTNodeOf<QTDerived> QTNode;
+	// if true, rigid tiles go into a read-only grid that's built once per Chunk, instead of into the Chunk's QuadTree along with everything that moves
+	constexpr static bool s_StaticTileBroadphase = true;
+	// if true, each Chunk merges neighboring rigid tiles into as few large Hitboxes as it can (see math::mergeRects) instead of making one per tile
+	constexpr static bool s_MergeRigidTiles = true;
+	// if true, each Chunk prints how many rigid tiles it merged and how many Hitboxes they became (see Chunk::GetMergeStats)
+	constexpr static bool s_MergeStats = false;
+	// if true, DynamicList finds overlapping pairs of dynamic Hitboxes once per frame with a math::SortAndSweep, and each Hitbox only checks the ones it was paired with instead of searching QTNode
+	constexpr static bool s_DynamicSweep = true;
+	// How far (in simulated pixels) either Hitbox in a pair can move before the math::PairCache runs the narrowphase for that pair again. Hitbox's narrowphase is swept, so any margin at all can delay collision events by a frame. 0 only reuses pairs where neither Hitbox moved.
+	constexpr static float s_PairCacheMargin = 0.f;
+	// Threads (counting the main one) that look for collisions between Dynamics and the static tiles they overlap, before they're resolved one at a time on the main thread. Capped at the number of cores, 1 does everything on the main thread. Needs s_DynamicSweep, since otherwise what a Dynamic collides with depends on where the ones resolved before it ended up.
+	constexpr static uint s_CollisionThreads = 4;
+	// if true, every broadphase and both kinds of element dispatch are timed on a crowd of moving Hitboxes at startup (see Hitbox::Benchmark)
+	constexpr static bool s_CollisionBenchmark = false;
+	// if true, every Script in res/scripts is run over and over at startup (see Script::Benchmark) and the interpreter's instructions per second are printed for each
+	constexpr static bool s_ScriptBenchmark = false;
+	// if true, each compiled script is saved next to its source (with a 'c' on the end of the extension) and loaded from there on later runs instead of being parsed again, as long as the source hasn't changed (see ScriptProgram)
+	constexpr static bool s_ScriptBytecodeCache = true;
+	// if true, each script is run through ScriptOptimizer after it's parsed
+	constexpr static bool s_ScriptOptimize = true;
+	// if true, ScriptOptimizer prints each script's instructions before and after optimizing it. Saved bytecode is ignored while this is on, so every script goes through the optimizer
+	constexpr static bool s_ScriptOptimizerDump = false;
 
 
 	struct EngineInstance
@@ -4,6 +4,7 @@
 #include "world/dynamic/Dynamic.h"
 #include "world/Camera.h"
 #include "world/World.h"
+#include "world/Hitbox.h"
 #include "script/Script.h"
 #include "world/dynamic/Character.h"
 
@@ -19,7 +20,20 @@ int main()
 	Sprite* s2 = world.PutSprite("res/idle.bmp", 1, 0);
 	Character* player = world.CreateCharacter("res/scripts/player.script", { 0.f, 0.f }, { 0.f, 0.f }, 100.f, { {"move", s1}, {"idle", s2} }, "idle");
 	Camera cam("res/scripts/camera.script", { 0.f, 0.f }, { 0.f, 0.f }, 100.f, player);
-	world.CreateDynamicTemplate("proj", {}, { { "a", s1 } }, "a", 200.f);
+	// Tiles keep the default filter (category 1, hits everything). Projectiles still hit tiles, but not the player that fired them or each other.
+	player->SetFilter({ 2, ~0u });
+	world.CreateDynamicTemplate("proj", {}, { { "a", s1 } }, "a", 200.f, { 4, ~(2u | 4u) });
+
+	if constexpr (s_CollisionBenchmark)
+		Hitbox::Benchmark(1000, 1.f);
+	if constexpr (s_ScriptBenchmark)
+	{
+		// same host and environment as the player's and camera's scripts get
+		std::vector<Scriptable*> env = { player };
+		for (const auto& entry : std::filesystem::directory_iterator("res/scripts"))
+			if (entry.path().extension() == ".script")
+				Script::Benchmark(entry.path().string().c_str(), { &renderer, &world }, player, env, 1.f);
+	}
 
 
 	while (engine.IsRunning())
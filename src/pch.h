@@ -1,6 +1,11 @@
 #pragma once
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
 #include <vector>
 #include <unordered_map>
+#include <map>
 #include <stdio.h>
 #include <iostream>
 #include <fstream>
@@ -38,6 +38,74 @@ namespace engine
 
 
 
+	// What an argument actually turned out to be once it was parsed. Labels and string literals are just int immediates by then. Each instruction gets its own handler for every combination of these that its ArgTypes allow, so handlers never have to check what they were given.
+	enum class Operand : uchar
+	{
+		NONE = 0, I, F, V, MI, MF
+	};
+	constexpr static bool IsImmediate(Operand o)
+	{
+		return o == Operand::MI || o == Operand::MF;
+	}
+	constexpr static bool Allows(ArgType a, Operand o)
+	{
+		const uint t = CAST(uint, a);
+		switch (o)
+		{
+		case Operand::I:	return t & CAST(uint, ArgType::I);
+		case Operand::F:	return t & CAST(uint, ArgType::F);
+		case Operand::V:	return t & CAST(uint, ArgType::V);
+		case Operand::MI:	return t & (CAST(uint, ArgType::MI) | CAST(uint, ArgType::L) | CAST(uint, ArgType::MS));
+		case Operand::MF:	return t & CAST(uint, ArgType::MF);
+		default:			return false;
+		}
+	}
+	// how many Operands an argument of the given type can be (an unused argument is always NONE)
+	constexpr static uint OperandCount(ArgType a)
+	{
+		if (a == ArgType::NONE)
+			return 1;
+		uint count = 0;
+		for (uint o = CAST(uint, Operand::I); o <= CAST(uint, Operand::MF); o++)
+			count += Allows(a, CAST(Operand, o));
+		return count;
+	}
+	// the i-th Operand that an argument of the given type can be, this is the order their handlers are laid out in
+	constexpr static Operand OperandAt(ArgType a, uint i)
+	{
+		if (a == ArgType::NONE)
+			return Operand::NONE;
+		for (uint o = CAST(uint, Operand::I); o <= CAST(uint, Operand::MF); o++)
+			if (Allows(a, CAST(Operand, o)) && i-- == 0)
+				return CAST(Operand, o);
+		return Operand::NONE;
+	}
+	// inverse of OperandAt
+	constexpr static uint OperandIndex(ArgType a, Operand o)
+	{
+		uint index = 0;
+		for (uint i = CAST(uint, Operand::I); i < CAST(uint, o); i++)
+			index += Allows(a, CAST(Operand, i));
+		return index;
+	}
+	static Operand ToOperand(ArgType a)
+	{
+		switch (a)
+		{
+		case ArgType::I:	return Operand::I;
+		case ArgType::F:	return Operand::F;
+		case ArgType::V:	return Operand::V;
+		case ArgType::MF:	return Operand::MF;
+		case ArgType::MI:
+		case ArgType::L:
+		case ArgType::MS:	return Operand::MI;
+		// NONE, or a combination that a parsed argument can't be
+		default:			return Operand::NONE;
+		}
+	}
+
+
+
 	struct CommandDescription
 	{
 		constexpr static uint s_RegCount = 3;
@@ -45,19 +113,36 @@ namespace engine
 
 		uchar opcode;
 		std::vector<ArgType> args;
+		// index of this instruction's first handler, see Script::Specialize
+		ushort handler;
 	};
 
 
 
-	struct Args
+	// what a handler was specialized for, the inverse of Script::HandlerIndex
+	struct HandlerDescription
 	{
-		// pointers to registers
-		int64_t* i[CommandDescription::s_RegCount] = { nullptr };
-		double* f[CommandDescription::s_RegCount] = { nullptr };
-		math::Vec2<float>* v[CommandDescription::s_RegCount] = { nullptr };
 		uchar opcode;
-		// immediate values
-		int64_t imm1i = 0, imm2i = 0;
-		double imm1f = 0.f;
+		Operand operands[CommandDescription::s_RegCount];
+	};
+
+
+
+	// One decoded instruction. ScriptParser already picked the handler for exactly the kinds of operands that were given, so this only needs to say where they are.
+	struct Args
+	{
+		// first int immediate (or label, or string address), or the float immediate. No instruction takes both.
+		union
+		{
+			int64_t imm1i = 0;
+			double imm1f;
+		};
+		// second int immediate (only ikd has one, so 16 bits is plenty)
+		int16_t imm2i = 0;
+		// index into Script::Handlers()
+		ushort handler = 0;
+		// for each operand that's a register, its index in the Registers array of its kind
+		uchar reg[CommandDescription::s_RegCount] = { 0 };
 	};
+	static_assert(sizeof(Args) == 16);
 }
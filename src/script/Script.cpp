@@ -7,36 +7,57 @@
 namespace engine
 {
 	Script::Script(const char* fp) :
-		m_Compiled(false),
+		Script(ScriptProgram::Load(fp))
+	{}
+	Script::Script(const ScriptProgram* const program) :
+		m_Program(program),
 		m_Abort(false),
 		m_Sleeping(false),
+		m_Quiet(false),
 		m_ProgramCounter(0),
-		m_EntryPoint(0),
 		m_StackPointer(0),
-		m_Stack{ 0 },
-		m_Memory{ 0 },
+		m_Memory(nullptr),
 		m_SleepEnd(0.f),
-		m_Filepath(fp)
+		m_Executed(0)
+	{}
+	Script::~Script()
 	{
-		if (s_CommandNames.empty())
-		{
-			for (uint i = 0; i < s_Instructions.size(); i++)
-			{
-				const auto& cur = s_Instructions[i];
-				s_CommandNames.emplace(i, cur.name);
-				s_CommandDescriptions.emplace(cur.name, CommandDescription(i, cur.desc));
-				s_Operations[i] = cur.op;
-			}
-		}
-
-		m_Compiled = ScriptParser(fp, this).Parse();
+		GetMemoryPool().Delete(m_Memory);
 	}
 
 
 
+	void* Script::operator new(size_t)
+	{
+		return GetScriptPool().Allocate();
+	}
+	void Script::operator delete(void* const script)
+	{
+		GetScriptPool().Free(script);
+	}
+	void Script::Describe()
+	{
+		if (!s_CommandNames.empty())
+			return;
+
+		constexpr auto instructions = Instructions();
+		uint handler = 0;
+		for (uint i = 0; i < instructions.size(); i++)
+		{
+			const auto& cur = instructions[i];
+			s_CommandNames.emplace(i, cur.name);
+			s_CommandDescriptions.emplace(cur.name, CommandDescription(i, std::vector<ArgType>(cur.desc, cur.desc + cur.argCount), CAST(ushort, handler)));
+			handler += cur.opCount;
+
+			// same layout as Specialize
+			const uint n1 = OperandCount(cur.desc[1]), n2 = OperandCount(cur.desc[2]);
+			for (uint j = 0; j < cur.opCount; j++)
+				s_HandlerDescriptions.push_back({ CAST(uchar, i), { OperandAt(cur.desc[0], j / (n1 * n2)), OperandAt(cur.desc[1], j / n2 % n1), OperandAt(cur.desc[2], j % n2) } });
+		}
+	}
 	Script::integer Script::Run(const ScriptRuntime& rt, Scriptable* const host, std::vector<Scriptable*>& env)
 	{
-		if (!m_Compiled)
+		if (!m_Program->IsCompiled())
 		{
 			printf("Cannot run a Script that failed to compile\n");
 			return 0;
@@ -48,7 +69,7 @@ namespace engine
 
 		// if this script was sleeping, have it resume from where it left off, otherwise start over
 		if (!m_Sleeping)
-			m_ProgramCounter = m_EntryPoint;
+			m_ProgramCounter = m_Program->GetEntryPoint();
 
 		// reset default values
 		m_Sleeping = false;
@@ -58,53 +79,127 @@ namespace engine
 		m_Registers.i[Registers::s_RegFlags] = 0;
 		m_SpawnQueue.clear();
 
-		while (!m_Abort && m_ProgramCounter < m_Instructions.size())
+		// these can't change while we're running
+		const float current = rt.renderer->GetTime(), delta = rt.renderer->GetFrameDelta();
+		const Args* const code = m_Program->GetInstructions().data();
+		const uint size = CAST(uint, m_Program->GetInstructions().size());
+		// Every handler is known at compile time, so each one gets its own copy of the dispatch code below and can be inlined into it. Args::handler picks which copy runs.
+		constexpr static auto handlers = Handlers();
+		static_assert(handlers.size() <= 256, "SCRIPT_REPEAT only covers 256 handlers");
+#define SCRIPT_REPEAT_16(M, n) M(n##0) M(n##1) M(n##2) M(n##3) M(n##4) M(n##5) M(n##6) M(n##7) M(n##8) M(n##9) M(n##a) M(n##b) M(n##c) M(n##d) M(n##e) M(n##f)
+#define SCRIPT_REPEAT(M) SCRIPT_REPEAT_16(M, 0x0) SCRIPT_REPEAT_16(M, 0x1) SCRIPT_REPEAT_16(M, 0x2) SCRIPT_REPEAT_16(M, 0x3) SCRIPT_REPEAT_16(M, 0x4) SCRIPT_REPEAT_16(M, 0x5) SCRIPT_REPEAT_16(M, 0x6) SCRIPT_REPEAT_16(M, 0x7) \
+	SCRIPT_REPEAT_16(M, 0x8) SCRIPT_REPEAT_16(M, 0x9) SCRIPT_REPEAT_16(M, 0xa) SCRIPT_REPEAT_16(M, 0xb) SCRIPT_REPEAT_16(M, 0xc) SCRIPT_REPEAT_16(M, 0xd) SCRIPT_REPEAT_16(M, 0xe) SCRIPT_REPEAT_16(M, 0xf)
+#define SCRIPT_CALL(n) if constexpr (s_ScriptBenchmark) m_Executed++; (this->*handlers[(n) % handlers.size()])(code[m_ProgramCounter], current, delta, rt.world, host, env)
+#if defined(__GNUC__)
+		// Threaded code: each handler jumps straight to the next one through its own indirect branch, instead of all of them returning to one shared one, which is much easier to predict
+#define SCRIPT_LABEL(n) &&handler_##n,
+#define SCRIPT_HANDLER(n) handler_##n: SCRIPT_CALL(n); ++m_ProgramCounter; if (m_Abort || m_ProgramCounter >= size) goto done; goto *labels[code[m_ProgramCounter].handler];
+		static void* const labels[] = { SCRIPT_REPEAT(SCRIPT_LABEL) };
+		if (m_ProgramCounter < size)
+			goto *labels[code[m_ProgramCounter].handler];
+		goto done;
+		SCRIPT_REPEAT(SCRIPT_HANDLER)
+	done:
+#undef SCRIPT_HANDLER
+#undef SCRIPT_LABEL
+#else
+		// same thing, but everything goes through the switch's jump
+#define SCRIPT_CASE(n) case n: SCRIPT_CALL(n); break;
+		while (!m_Abort && m_ProgramCounter < size)
 		{
-			const auto& cur = m_Instructions[m_ProgramCounter];
-			(this->*(s_Operations[cur.opcode]))(cur, rt.renderer->GetTime(), rt.renderer->GetFrameDelta(), rt.world, host, env);
+			switch (code[m_ProgramCounter].handler)
+			{
+				SCRIPT_REPEAT(SCRIPT_CASE)
+			}
 			m_ProgramCounter++;
 		}
+#undef SCRIPT_CASE
+#endif
+#undef SCRIPT_CALL
+#undef SCRIPT_REPEAT
+#undef SCRIPT_REPEAT_16
 
 		for (Dynamic* spawned : m_SpawnQueue)
 			spawned->AddTo(rt.world->m_Map->GetCurrentQuadTree(), *rt.world->m_DynamicList);
 
 		return m_Registers.i[Registers::s_RegFlags];
 	}
+	void Script::Benchmark(const char* fp, const ScriptRuntime& rt, Scriptable* const host, std::vector<Scriptable*>& env, float seconds)
+	{
+		// a separate run of the same program, so that the ones actually in use keep their state
+		Script* const script = new Script(fp);
+		if (!script->m_Program->IsCompiled())
+		{
+			delete script;
+			return;
+		}
+		script->m_Quiet = true;
+		const math::Vec2<float> pos = host->GetPos(), vel = host->GetVel();
+
+		typedef std::chrono::steady_clock clock;
+		const auto start = clock::now();
+		ulong runs = 0;
+		double elapsed = 0.;
+		// only check the clock every so often, so that it doesn't count against the Script
+		do
+		{
+			for (uint i = 0; i < 1024; i++)
+				script->Run(rt, host, env);
+			runs += 1024;
+			elapsed = std::chrono::duration<double>(clock::now() - start).count();
+		} while (elapsed < seconds);
+
+		host->SetPos(pos);
+		host->SetVel(vel);
+		printf("[%s]: %llu instructions in %llu runs (%fs), %f million instructions per second\n", fp, CAST(unsigned long long, script->m_Executed), CAST(unsigned long long, runs), elapsed, script->m_Executed / elapsed / 1000000.);
+		delete script;
+	}
 
 
 
-	Script::integer* const Script::GetIntRegister(uint index)
+	int Script::GetIntRegister(uint index)
 	{
 		if (index <= 18)
-			return &m_Registers.i[index];
+			return index;
 		if (index >= 24 && index <= 26)
-			return &m_Registers.i[index - 5];
-		if (index >= 49)
-			return &m_Registers.i[index - 27];
+			return index - 5;
+		if (index >= 49 && index < 49 + Registers::s_IntRegCount - 22)
+			return index - 27;
 
-		return nullptr;
+		return -1;
 	}
-	Script::fp* const Script::GetFloatRegister(uint index)
+	int Script::GetFloatRegister(uint index)
 	{
 		if (index >= 19 && index <= 21)
-			return &m_Registers.f[index - 19];
+			return index - 19;
 		if (index >= 27 && index <= 29)
-			return &m_Registers.f[index - 24];
+			return index - 24;
 		if (index >= 32 && index <= 39)
-			return &m_Registers.f[index - 26];
+			return index - 26;
 
-		return nullptr;
+		return -1;
 	}
-	Script::vec* const Script::GetVecRegister(uint index)
+	int Script::GetVecRegister(uint index)
 	{
 		if (index >= 22 && index <= 23)
-			return &m_Registers.v[index - 22];
+			return index - 22;
 		if (index >= 30 && index <= 31)
-			return &m_Registers.v[index - 28];
+			return index - 28;
 		if (index >= 40 && index <= 48)
-			return &m_Registers.v[index - 36];
+			return index - 36;
 
-		return nullptr;
+		return -1;
+	}
+	uint Script::HandlerIndex(const CommandDescription& description, const Operand* const operands)
+	{
+		// same order as Specialize lays them out in, with the first operand varying the slowest
+		uint index = 0;
+		for (uint i = 0; i < CommandDescription::s_RegCount; i++)
+		{
+			const ArgType desc = i < description.args.size() ? description.args[i] : ArgType::NONE;
+			index = index * OperandCount(desc) + OperandIndex(desc, operands[i]);
+		}
+		return description.handler + index;
 	}
 	bool Script::RangeCheck(integer i, integer min, integer max)
 	{
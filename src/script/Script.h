@@ -3,6 +3,8 @@
 #include "Command.h"
 #include "world/World.h"
 #include "Scriptable.h"
+#include "ScriptProgram.h"
+#include "ScriptOptimizer.h"
 
 namespace engine
 {
@@ -17,7 +19,8 @@ namespace engine
 	};
 
 
-	class Script
+	// One run of a ScriptProgram: its registers, where it is in the program, and (once it uses them) a stack and RAM. Scripts come from a pool, and several of them can run the same ScriptProgram without getting in each other's way.
+	class Script final
 	{
 	private:
 		typedef int64_t integer;
@@ -25,17 +28,36 @@ namespace engine
 		typedef math::Vec2<float> vec;
 	public:
 		friend class ScriptParser;
+		friend class ScriptProgram;
+		friend class ScriptOptimizer;
 
 
 		Script(const char* fp);
+		Script(const ScriptProgram* const program);
 		Script(const Script& other) = delete;
 		Script(Script&& other) = delete;
+		~Script();
+
+
+		// Script is final, so this only ever has to make room for exactly one Script
+		static void* operator new(size_t);
+		static void operator delete(void* const script);
+		// fills in s_CommandNames, s_CommandDescriptions, and s_HandlerDescriptions the first time it's called, ScriptParser needs them
+		static void Describe();
 
 
 		integer Run(const ScriptRuntime& rt, Scriptable* const host, std::vector<Scriptable*>& env);
+		// Runs its own copy of the Script at fp for about the given number of seconds and prints how many instructions per second it got through. Needs s_ScriptBenchmark to count them. Debug ops don't print while this runs, and host's position and velocity are put back afterwards.
+		static void Benchmark(const char* fp, const ScriptRuntime& rt, Scriptable* const host, std::vector<Scriptable*>& env, float seconds);
 	private:
-		// 8KB stack, 4KB RAM, 128 supported operations
-		constexpr static uint s_StackCount = 8192 / (sizeof(ulong) / sizeof(uchar)), s_MemCount = 4096, s_OpCount = 128;
+		// 8KB stack, 4KB RAM
+		constexpr static uint s_StackCount = 8192 / (sizeof(ulong) / sizeof(uchar)), s_MemCount = ScriptProgram::s_MemCount;
+		// stack and RAM are only given to Scripts that use them, see GetMemory
+		struct Memory
+		{
+			ulong stack[s_StackCount];
+			uchar ram[s_MemCount];
+		};
 		// special value representing the "host" of this Script invocation
 		constexpr static int s_HostIndex = -1;
 		// special register indices
@@ -58,20 +80,58 @@ namespace engine
 		};
 
 
-		bool m_Compiled, m_Abort, m_Sleeping;
-		uchar m_Memory[s_MemCount];
-		uint m_ProgramCounter, m_EntryPoint, m_StackPointer;
-		ulong m_Stack[s_StackCount];
+		// these are never freed, since Scripts can outlive any other static
+		static math::Pool<Script>& GetScriptPool()
+		{
+			static math::Pool<Script>* const pool = new math::Pool<Script>();
+			return *pool;
+		}
+		static math::Pool<Memory, 8>& GetMemoryPool()
+		{
+			static math::Pool<Memory, 8>* const pool = new math::Pool<Memory, 8>();
+			return *pool;
+		}
+
+
+		const ScriptProgram* const m_Program;
+		bool m_Abort, m_Sleeping, m_Quiet;
+		uint m_ProgramCounter, m_StackPointer;
+		// nullptr until the first instruction that needs it
+		Memory* m_Memory;
 		float m_SleepEnd;
+		// instructions run so far, only counted if s_ScriptBenchmark
+		ulong m_Executed;
 		Registers m_Registers;
-		std::vector<Args> m_Instructions;
 		std::vector<Dynamic*> m_SpawnQueue;
-		std::string m_Filepath;
 
 
-		integer* const GetIntRegister(uint index);
-		fp* const GetFloatRegister(uint index);
-		vec* const GetVecRegister(uint index);
+		// index into m_Registers.i/f/v of the register with the given index in the script's numbering, or -1
+		static int GetIntRegister(uint index);
+		static int GetFloatRegister(uint index);
+		static int GetVecRegister(uint index);
+		// stack and RAM, taken from the pool (with the program's string literals copied in) the first time they're needed
+		Memory& GetMemory()
+		{
+			if (!m_Memory)
+			{
+				m_Memory = GetMemoryPool().New();
+				const uint start = m_Program->GetDataStart();
+				std::copy(m_Program->GetData(), m_Program->GetData() + (s_MemCount - start), m_Memory->ram + start);
+			}
+			return *m_Memory;
+		}
+		// string at the given address in RAM. Until something could have written to RAM, that's the same as reading it straight out of the program.
+		const char* GetString(integer address)
+		{
+			const uint start = m_Program->GetDataStart();
+			if (!m_Memory && address >= start && address < s_MemCount)
+				return (const char*)(m_Program->GetData() + (address - start));
+			if (!RangeCheck(address, 0, s_MemCount))
+				return "";
+			return (const char*)(GetMemory().ram + address);
+		}
+		// handler for instruction description given what each of its operands turned out to be
+		static uint HandlerIndex(const CommandDescription& description, const Operand* const operands);
 		bool RangeCheck(integer i, integer min, integer max);
 		template<typename T>
 		void StackPush(const T& t)
@@ -83,7 +143,7 @@ namespace engine
 				return;
 			}
 
-			m_Stack[m_StackPointer++] = PUN(ulong, t);
+			GetMemory().stack[m_StackPointer++] = PUN(ulong, t);
 		}
 		template<typename T>
 		T StackPop()
@@ -95,282 +155,318 @@ namespace engine
 				return CAST(T, 0);
 			}
 
-			return PUN(T, m_Stack[--m_StackPointer]);
+			return PUN(T, GetMemory().stack[--m_StackPointer]);
+		}
+
+
+		// the kind of operand n of a handler specialized for A0, A1, A2
+		template<uint N, Operand A0, Operand A1, Operand A2>
+		constexpr static Operand Kind()
+		{
+			return N == 0 ? A0 : (N == 1 ? A1 : A2);
+		}
+		// register operand n, of whichever kind it is
+		template<Operand K>
+		auto& Reg(const Args& args, uint n)
+		{
+			static_assert(K == Operand::I || K == Operand::F || K == Operand::V, "Operand is not a register");
+			if constexpr (K == Operand::I)
+				return m_Registers.i[args.reg[n]];
+			else if constexpr (K == Operand::F)
+				return m_Registers.f[args.reg[n]];
+			else
+				return m_Registers.v[args.reg[n]];
+		}
+		// value of operand n, whether it's a register or an immediate
+		template<uint N, Operand A0, Operand A1, Operand A2>
+		auto Val(const Args& args)
+		{
+			constexpr Operand k = Kind<N, A0, A1, A2>();
+			// immediates are stored in the order they were given
+			constexpr bool second = (N > 0 && IsImmediate(A0)) || (N > 1 && IsImmediate(A1));
+			if constexpr (k == Operand::MI)
+				return second ? CAST(integer, args.imm2i) : args.imm1i;
+			else if constexpr (k == Operand::MF)
+				return args.imm1f;
+			else
+				return Reg<k>(args, N);
+		}
+		// beq/bne compare as vecs if either side is one
+		template<typename A, typename B>
+		static bool Equal(const A& a, const B& b)
+		{
+			if constexpr (std::is_same_v<A, vec> || std::is_same_v<B, vec>)
+				return vec(a) == vec(b);
+			else
+				return a == b;
 		}
 
 
+		typedef void(Script::* Operation)(const Args&, float, float, World* const, Scriptable* const, std::vector<Scriptable*>&);
+// Each handler is a template over the kind of each of its operands (see Operand), and name_t::Get hands out a specialization of it for Specialize
 #define I(name, code) \
-	void name(const Args& args, float current, float delta, World* const world, Scriptable* const host, std::vector<Scriptable*>& env) { code }
-#define ROI(r, i) ((r) ? (*r) : (i))
+	template<Operand A0, Operand A1, Operand A2> \
+	void name(const Args& args, float current, float delta, World* const world, Scriptable* const host, std::vector<Scriptable*>& env) { code } \
+	struct name##_t { template<Operand A0, Operand A1, Operand A2> constexpr static Operation Get() { return &Script::name<A0, A1, A2>; } };
+// kind of operand n
+#define K(n) Kind<n, A0, A1, A2>()
+// operand n, which has to be a register
+#define R(n) Reg<K(n)>(args, n)
+// operand n, register or immediate
+#define ROI(n) Val<n, A0, A1, A2>(args)
 
 		// math
 		I(add,
-			*args.i[2] = *args.i[0] + ROI(args.i[1], args.imm1i);
+			R(2) = R(0) + ROI(1);
 		);
 		I(addf,
-			*args.f[2] = *args.f[0] + ROI(args.f[1], args.imm1f);
+			R(2) = R(0) + ROI(1);
 			);
 		I(addv,
-			*args.v[2] = *args.v[0] + ROI(args.v[1], ROI(args.f[1], args.imm1f));
+			R(2) = R(0) + ROI(1);
 			);
 		I(sub,
-			*args.i[2] = *args.i[0] - ROI(args.i[1], args.imm1i);
+			R(2) = R(0) - ROI(1);
 		);
 		I(subf,
-			*args.f[2] = *args.f[0] - ROI(args.f[1], args.imm1f);
+			R(2) = R(0) - ROI(1);
 		);
 		I(subv,
-			*args.v[2] = *args.v[0] - ROI(args.v[1], ROI(args.f[1], args.imm1f));
+			R(2) = R(0) - ROI(1);
 		);
 		I(mul,
-			*args.i[2] = *args.i[0] * ROI(args.i[1], args.imm1i);
+			R(2) = R(0) * ROI(1);
 		);
 		I(mulf,
-			*args.f[2] = *args.f[0] * ROI(args.f[1], args.imm1f);
+			R(2) = R(0) * ROI(1);
 		);
 		I(mulv,
-			*args.v[2] = *args.v[0] * ROI(args.v[1], ROI(args.f[1], args.imm1f));
+			R(2) = R(0) * ROI(1);
 		);
 		I(div,
-			*args.i[2] = *args.i[0] / ROI(args.i[1], args.imm1i);
+			R(2) = R(0) / ROI(1);
 		);
 		I(divf,
-			*args.f[2] = *args.f[0] / ROI(args.f[1], args.imm1f);
+			R(2) = R(0) / ROI(1);
 		);
 		I(divv,
-			*args.v[2] = *args.v[0] / ROI(args.v[1], ROI(args.f[1], args.imm1f));
+			R(2) = R(0) / ROI(1);
 		);
 		// math.bit
 		I(band,
-			*args.i[2] = *args.i[0] & ROI(args.i[1], args.imm1i);
+			R(2) = R(0) & ROI(1);
 		);
 		I(bxor,
-			*args.i[2] = *args.i[0] ^ ROI(args.i[1], args.imm1i);
+			R(2) = R(0) ^ ROI(1);
 		);
 		I(bor,
-			*args.i[2] = *args.i[0] | ROI(args.i[1], args.imm1i);
+			R(2) = R(0) | ROI(1);
 		);
 		I(bnot,
-			*args.i[1] = ~ROI(args.i[0], args.imm1i);
+			R(1) = ~ROI(0);
 		);
 		I(sl,
-			*args.i[2] = (*args.i[0]) << ROI(args.i[1], args.imm1i);
+			R(2) = R(0) << ROI(1);
 		);
 		I(sr,
-			*args.i[2] = (*args.i[0]) >> ROI(args.i[1], args.imm1i);
+			R(2) = R(0) >> ROI(1);
 		);
 		// math.trig
 		I(sine,
-			*args.f[1] = math::sin(*args.f[0]);
+			R(1) = math::sin(R(0));
 		);
 		I(cosine,
-			*args.f[1] = math::cos(*args.f[0]);
+			R(1) = math::cos(R(0));
 		);
 		I(tangent,
-			*args.f[1] = math::tan(*args.f[0]);
+			R(1) = math::tan(R(0));
 		);
 		I(arcsine,
-			*args.f[1] = math::asin(*args.f[0]);
+			R(1) = math::asin(R(0));
 		);
 		I(arccosine,
-			*args.f[1] = math::acos(*args.f[0]);
+			R(1) = math::acos(R(0));
 		);
 		I(arctangent,
-			*args.f[2] = math::atan(*args.f[0], *args.f[1]);
+			R(2) = math::atan(R(0), R(1));
 		);
 		// math.fn
 		I(min,
-			*args.i[2] = math::min(*args.i[0], ROI(args.i[1], args.imm1i));
+			R(2) = math::min(R(0), ROI(1));
 		);
 		I(max,
-			*args.i[2] = math::max(*args.i[0], ROI(args.i[1], args.imm1i));
+			R(2) = math::max(R(0), ROI(1));
 		);
 		I(minf,
-			*args.f[2] = math::min(*args.f[0], ROI(args.f[1], args.imm1f));
+			R(2) = math::min(R(0), ROI(1));
 		);
 		I(maxf,
-			*args.f[2] = math::max(*args.f[0], ROI(args.f[1], args.imm1f));
+			R(2) = math::max(R(0), ROI(1));
 		);
 		I(minv,
-			*args.f[1] = math::min(args.v[0]->x, args.v[0]->y);
+			R(1) = math::min(R(0).x, R(0).y);
 			);
 		I(maxv,
-			*args.f[1] = math::max(args.v[0]->x, args.v[0]->y);
+			R(1) = math::max(R(0).x, R(0).y);
 			);
 		I(power,
-			*args.f[2] = math::pow(*args.f[0], ROI(args.f[1], args.imm1f));
+			R(2) = math::pow(R(0), ROI(1));
 			);
 		I(squareroot,
-			*args.f[1] = math::sqrt(ROI(args.f[0], args.imm1f));
+			R(1) = math::sqrt(ROI(0));
 			);
 		I(absolute,
-			*args.i[1] = math::abs(ROI(args.i[0], args.imm1i));
+			R(1) = math::abs(ROI(0));
 			);
 		I(absolutef,
-			*args.f[1] = math::abs(ROI(args.f[0], args.imm1f));
+			R(1) = math::abs(ROI(0));
 		);
 		I(absolutev,
-			*args.v[1] = args.v[0]->Abs();
+			R(1) = R(0).Abs();
 		);
 		I(random,
-			*args.i[2] = math::rand(*args.i[0], ROI(args.i[1], args.imm1i));
+			R(2) = math::rand(R(0), ROI(1));
 			);
 		I(randomf,
-			*args.f[2] = math::rand(*args.f[0], ROI(args.f[1], args.imm1f));
+			R(2) = math::rand(R(0), ROI(1));
 		);
 		I(sign,
-			*args.i[1] = math::sign(ROI(args.i[0], args.imm1i));
+			R(1) = math::sign(ROI(0));
 		);
 		I(signf,
-			*args.f[1] = math::sign(ROI(args.f[0], args.imm1f));
+			R(1) = math::sign(ROI(0));
 		);
 		I(signv,
-			*args.v[1] = args.v[0]->Unit();
+			R(1) = R(0).Unit();
 		);
 		// math.vec
 		I(dot,
-			*args.f[2] = args.v[0]->Dot(*args.v[1]);
+			R(2) = R(0).Dot(R(1));
 			);
 		I(mag,
-			*args.f[1] = args.v[0]->Magnitude();
+			R(1) = R(0).Magnitude();
 			);
 		I(ang,
-			*args.f[1] = math::deg(args.v[0]->Angle());
+			R(1) = math::deg(R(0).Angle());
 			);
 		I(angv,
-			*args.f[2] = math::deg(args.v[0]->AngleBetween(*args.v[1]));
+			R(2) = math::deg(R(0).AngleBetween(R(1)));
 			);
 		I(norm,
-			*args.v[1] = args.v[0]->Normalized();
+			R(1) = R(0).Normalized();
 			);
 		// mem
 		I(psh,
-			if (args.i[0])
-				StackPush(*args.i[0]);
-			else if (args.f[0])
-				StackPush(*args.f[0]);
-			else
-				StackPush(*args.v[0]);
+			StackPush(R(0));
 		);
 		I(pop,
-			if (args.i[0])
-				*args.i[0] = StackPop<integer>();
-			else if (args.f[0])
-				*args.f[0] = StackPop<fp>();
-			else
-				*args.v[0] = StackPop<vec>();
+			auto& dst = R(0);
+			dst = StackPop<std::remove_reference_t<decltype(dst)>>();
 		);
 		I(mov,
-			*args.i[1] = CAST(integer, ROI(args.f[0], ROI(args.i[0], args.imm1i)));
+			R(1) = CAST(integer, ROI(0));
 		);
 		I(movl,
-			*args.i[1] &= Registers::s_RegMaskHi;
-			*args.i[1] |= ROI(args.i[0], args.imm1i);
+			R(1) &= Registers::s_RegMaskHi;
+			R(1) |= ROI(0);
 		);
 		I(movh,
-			*args.i[1] &= Registers::s_RegMaskLo;
-			*args.i[1] |= (ROI(args.i[0], args.imm1i) << 32);
+			R(1) &= Registers::s_RegMaskLo;
+			R(1) |= (ROI(0) << 32);
 		);
 		I(movf,
-			*args.f[1] = CAST(fp, ROI(args.f[0], ROI(args.i[0], args.imm1f)));
+			R(1) = CAST(fp, ROI(0));
 		);
 		I(movv,
-			*args.v[1] = ROI(args.v[0], ROI(args.i[0], ROI(args.f[0], args.imm1f)));
+			R(1) = ROI(0);
 		);
 		I(movx,
-			if (args.v[0])
-				args.v[1]->x = args.v[0]->x;
+			if constexpr (K(0) == Operand::V)
+				R(1).x = R(0).x;
 			else
-				args.v[1]->x = CAST(float, ROI(args.i[0], ROI(args.f[0], args.imm1f)));
+				R(1).x = CAST(float, ROI(0));
 		);
 		I(movy,
-			if (args.v[0])
-				args.v[1]->y = args.v[0]->y;
+			if constexpr (K(0) == Operand::V)
+				R(1).y = R(0).y;
 			else
-				args.v[1]->y = CAST(float, ROI(args.i[0], ROI(args.f[0], args.imm1f)));
+				R(1).y = CAST(float, ROI(0));
 		);
 		I(stm,
-			const integer index = ROI(args.i[1], args.imm1i);
-			if (!RangeCheck(index, 0, s_MemCount))
+			const integer index = ROI(1);
+			// all 8 bytes have to fit
+			if (!RangeCheck(index, 0, s_MemCount - sizeof(ulong) + 1))
 				return;
 
 			// write to memory in chunks of 8 bytes by casting to a ulong pointer
-			if (args.i[0])
-				*((ulong*)(&m_Memory[index])) = *(ulong*)args.i[0];
-			else if (args.f[0])
-				*((ulong*)(&m_Memory[index])) = *(ulong*)args.f[0];
-			else if (args.v[0])
-				*((ulong*)(&m_Memory[index])) = *(ulong*)args.v[0];
+			auto& src = R(0);
+			*((ulong*)(&GetMemory().ram[index])) = PUN(ulong, src);
 		);
 		I(ldm,
-			const integer index = ROI(args.i[1], args.imm1i);
+			const integer index = ROI(0);
 			if (!RangeCheck(index, 0, s_MemCount))
 				return;
 
-			if (args.i[1])
-				*args.i[1] = PUN(integer, m_Memory[index]);
-			else if (args.f[1])
-				*args.f[1] = PUN(fp, m_Memory[index]);
-			else if (args.v[1])
-				*args.v[1] = PUN(vec, m_Memory[index]);
+			auto& dst = R(1);
+			dst = PUN(std::remove_reference_t<decltype(dst)>, GetMemory().ram[index]);
 			);
 		// ctrl
 		I(beq,
-			if (!RangeCheck(args.imm1i, 0, m_Instructions.size()))
+			if (!RangeCheck(args.imm1i, 0, m_Program->GetInstructions().size()))
 				return;
 
-			if (ROI(args.i[0], ROI(args.f[0], *args.v[0])) == ROI(args.i[1], ROI(args.f[1], *args.v[1])))
+			if (Equal(ROI(0), ROI(1)))
 				m_ProgramCounter = CAST(uint, args.imm1i) - 1;
 		);
 		I(beqz,
-			if (!RangeCheck(args.imm1i, 0, m_Instructions.size()))
+			if (!RangeCheck(args.imm1i, 0, m_Program->GetInstructions().size()))
 				return;
 
-			if (ROI(args.i[0], ROI(args.f[0], *args.v[0])) == 0)
+			if (R(0) == 0)
 				m_ProgramCounter = CAST(uint, args.imm1i) - 1;
 		);
 		I(bne,
-			if (!RangeCheck(args.imm1i, 0, m_Instructions.size()))
+			if (!RangeCheck(args.imm1i, 0, m_Program->GetInstructions().size()))
 				return;
 
-			if (ROI(args.i[0], ROI(args.f[0], *args.v[0])) != ROI(args.i[1], ROI(args.f[1], *args.v[1])))
+			if (!Equal(ROI(0), ROI(1)))
 				m_ProgramCounter = CAST(uint, args.imm1i) - 1;
 		);
 		I(blt,
-			if (!RangeCheck(args.imm1i, 0, m_Instructions.size()))
+			if (!RangeCheck(args.imm1i, 0, m_Program->GetInstructions().size()))
 				return;
 
-			if (ROI(args.i[0], *args.f[0]) < ROI(args.i[1], *args.f[1]))
+			if (R(0) < R(1))
 				m_ProgramCounter = CAST(uint, args.imm1i) - 1;
 		);
 		I(bgt,
-			if (!RangeCheck(args.imm1i, 0, m_Instructions.size()))
+			if (!RangeCheck(args.imm1i, 0, m_Program->GetInstructions().size()))
 				return;
 
-			if (ROI(args.i[0], *args.f[0]) > ROI(args.i[1], *args.f[1]))
+			if (R(0) > R(1))
 				m_ProgramCounter = CAST(uint, args.imm1i) - 1;
 		);
 		I(ble,
-			if (!RangeCheck(args.imm1i, 0, m_Instructions.size()))
+			if (!RangeCheck(args.imm1i, 0, m_Program->GetInstructions().size()))
 				return;
 
-			if (ROI(args.i[0], *args.f[0]) <= ROI(args.i[1], *args.f[1]))
+			if (R(0) <= R(1))
 				m_ProgramCounter = CAST(uint, args.imm1i) - 1;
 		);
 		I(bge,
-			if (!RangeCheck(args.imm1i, 0, m_Instructions.size()))
+			if (!RangeCheck(args.imm1i, 0, m_Program->GetInstructions().size()))
 				return;
 
-			if (ROI(args.i[0], *args.f[0]) >= ROI(args.i[1], *args.f[1]))
+			if (R(0) >= R(1))
 				m_ProgramCounter = CAST(uint, args.imm1i) - 1;
 		);
 		I(j,
-			if (!RangeCheck(args.imm1i, 0, m_Instructions.size()))
+			if (!RangeCheck(args.imm1i, 0, m_Program->GetInstructions().size()))
 				return;
 			m_ProgramCounter = CAST(uint, args.imm1i) - 1;
 		);
 		I(call,
-			if (!RangeCheck(args.imm1i, 0, m_Instructions.size()))
+			if (!RangeCheck(args.imm1i, 0, m_Program->GetInstructions().size()))
 				return;
 			StackPush(m_ProgramCounter);
 			m_ProgramCounter = CAST(uint, args.imm1i) - 1;
@@ -382,194 +478,303 @@ namespace engine
 			m_Abort = true;
 		);
 		I(slp,
-			m_SleepEnd = current + ROI(args.i[0], args.imm1i);
+			m_SleepEnd = current + ROI(0);
 			m_Sleeping = true;
 			m_Abort = true;
 		);
 		I(blk,
-			math::sleep(CAST(uint, ROI(args.i[0], args.imm1i)));
+			math::sleep(CAST(uint, ROI(0)));
 		);
 		// debug
 		I(dbg,
-			printf("[%s]: %lld\n", m_Filepath.c_str(), ROI(args.i[0], args.imm1i));
+			if (!m_Quiet)
+				printf("[%s]: %lld\n", m_Program->GetFilepath().c_str(), ROI(0));
 		);
 		I(dbgf,
-			printf("[%s]: %f\n", m_Filepath.c_str(), ROI(args.f[0], args.imm1f));
+			if (!m_Quiet)
+				printf("[%s]: %f\n", m_Program->GetFilepath().c_str(), ROI(0));
 		);
 		I(dbgv,
-			printf("[%s]: <%f, %f>\n", m_Filepath.c_str(), args.v[0]->x, args.v[0]->y);
+			if (!m_Quiet)
+				printf("[%s]: <%f, %f>\n", m_Program->GetFilepath().c_str(), R(0).x, R(0).y);
 		);
 		I(dbgs,
-			printf("[%s]: %s\n", m_Filepath.c_str(), (char*)(m_Memory + ROI(args.i[0], args.imm1i)));
+			if (!m_Quiet)
+				printf("[%s]: %s\n", m_Program->GetFilepath().c_str(), GetString(ROI(0)));
 		);
 		// engine
 		I(gettime,
-			*args.f[0] = current;
+			R(0) = current;
 		);
 		// engine.input
 		I(imp,
-			*args.v[0] = world->m_Engine->GetCursorPos();
+			R(0) = world->m_Engine->GetCursorPos();
 		);
 		I(ims,
-			*args.v[0] = world->m_Engine->GetScroll();
+			R(0) = world->m_Engine->GetScroll();
 		);
 		I(imb,
-			*args.i[1] = CAST(integer, world->m_Engine->IsMousePressed(CAST(uint, ROI(args.i[0], args.imm1i))));
+			R(1) = CAST(integer, world->m_Engine->IsMousePressed(CAST(uint, ROI(0))));
 		);
 		I(ikp,
-			*args.i[1] = CAST(integer, world->m_Engine->IsKeyPressed(CAST(uint, ROI(args.i[0], args.imm1i))));
+			R(1) = CAST(integer, world->m_Engine->IsKeyPressed(CAST(uint, ROI(0))));
 		);
 		I(ikd,
-			const integer a = CAST(integer, world->m_Engine->IsKeyPressed(CAST(uint, ROI(args.i[0], args.imm1i))));
-			const integer b = CAST(integer, world->m_Engine->IsKeyPressed(CAST(uint, ROI(args.i[1], args.imm2i))));
-			*args.i[2] = a - b;
+			const integer a = CAST(integer, world->m_Engine->IsKeyPressed(CAST(uint, ROI(0))));
+			const integer b = CAST(integer, world->m_Engine->IsKeyPressed(CAST(uint, ROI(1))));
+			R(2) = a - b;
 		);
 		// engine.obj
 #define CS (m_Registers.i[Registers::s_RegObj] == s_HostIndex ? host : env[m_Registers.i[Registers::s_RegObj]])
 		I(ogp,
-			*args.v[0] = CS->GetPos();
+			R(0) = CS->GetPos();
 		);
 		I(osp,
-			CS->SetPos(*args.v[0]);
+			CS->SetPos(R(0));
 		);
 		I(ogv,
-			*args.v[0] = CS->GetVel();
+			R(0) = CS->GetVel();
 		);
 		I(osv,
-			CS->SetVel(*args.v[0]);
+			CS->SetVel(R(0));
 		);
 		I(ogd,
-			*args.v[0] = CS->GetDims();
+			R(0) = CS->GetDims();
 		);
 		I(ogs,
-			*args.f[0] = CS->GetSpeed();
+			R(0) = CS->GetSpeed();
 		);
 		I(oss,
-			CS->SetState((char*)(m_Memory + ROI(args.i[0], args.imm1i)));
+			CS->SetState(GetString(ROI(0)));
+		);
+		I(ogc,
+			R(0) = CAST(integer, CS->GetFilter().category);
+		);
+		I(osc,
+			CS->SetFilter({ CAST(uint, ROI(0)), CS->GetFilter().mask });
+		);
+		I(ogm,
+			R(0) = CAST(integer, CS->GetFilter().mask);
+		);
+		I(osm,
+			CS->SetFilter({ CS->GetFilter().category, CAST(uint, ROI(0)) });
+		);
+		// state of this object in the named Trigger this frame: 0 outside, 1 entered, 2 stayed, 3 exited
+		I(otp,
+			const int trigger = world->FindTrigger(GetString(ROI(0)));
+			R(1) = trigger == -1 ? 0 : CAST(integer, CS->GetTriggers().GetState(CAST(uint, trigger)));
+		);
+		// next of this frame's Trigger events, (-1, 0) once there are none left
+		I(otn,
+			TriggerTracker::Event event;
+			const bool found = CS->GetTriggers().Next(&event);
+			R(0) = found ? CAST(integer, event.trigger) : -1;
+			R(1) = found ? CAST(integer, event.type) : 0;
 		);
 		I(spn,
-			Dynamic* d = world->CreateDynamic((char*)(m_Memory + ROI(args.i[0], args.imm1i)), false);
+			Dynamic* d = world->CreateDynamic(GetString(ROI(0)), false);
 			env.push_back((Scriptable*)d);
 			m_Registers.i[Registers::s_RegObjCount]++;
 			m_SpawnQueue.push_back(d);
-			*args.i[1] = env.size() - 1;
+			R(1) = env.size() - 1;
+		);
+		// engine.world
+		I(wsp,
+			R(1) = CAST(integer, world->IsSolid(R(0)));
+		);
+		I(wsr,
+			R(2) = CAST(integer, world->IsSolid(R(0), R(1)));
+		);
+		I(wti,
+			R(1) = CAST(integer, world->FindTrigger(GetString(ROI(0))));
 		);
 #undef CS
 #undef ROI
+#undef R
+#undef K
 #undef I
 
 
-		typedef void(Script::* Operation)(const Args&, float, float, World* const, Scriptable* const, std::vector<Scriptable*>&);
-		// these 3 will be auto-populated from s_Instructions
-		static inline Operation s_Operations[s_OpCount];
+		// these 3 will be auto-populated from Instructions()
 		static inline std::unordered_map<uint, std::string> s_CommandNames;
 		static inline std::unordered_map<std::string, CommandDescription> s_CommandDescriptions;
+		// indexed by Args::handler
+		static inline std::vector<HandlerDescription> s_HandlerDescriptions;
+		// most handlers any one instruction has
+		constexpr static uint s_MaxSpecializations = 16;
 		struct Instruction
 		{
-			std::string name;
-			std::vector<ArgType> desc;
-			Operation op;
+			const char* name;
+			ArgType desc[CommandDescription::s_RegCount];
+			uint argCount, opCount;
+			// a handler for every combination of Operands that desc allows, see HandlerIndex
+			Operation ops[s_MaxSpecializations];
 		};
-		const static inline std::vector<Instruction> s_Instructions =
+		// Instruction whose handler is H's name, specialized for everything that DESC allows
+		template<typename H, ArgType... DESC>
+		constexpr static Instruction Specialize(const char* name)
 		{
-			// math
-			{ "add",	{ ArgType::I, ArgType::I_MI, ArgType::I }, &Script::add },
-			{ "addf",	{ ArgType::F, ArgType::F_MF, ArgType::F }, &Script::addf },
-			{ "addv",	{ ArgType::V, ArgType::F_V_MF, ArgType::V }, &Script::addv },
-			{ "sub",	{ ArgType::I, ArgType::I_MI, ArgType::I }, &Script::sub },
-			{ "subf",	{ ArgType::F, ArgType::F_MF, ArgType::F }, &Script::subf },
-			{ "subv",	{ ArgType::V, ArgType::F_V_MF, ArgType::V }, &Script::subv },
-			{ "mul",	{ ArgType::I, ArgType::I_MI, ArgType::I }, &Script::mul },
-			{ "mulf",	{ ArgType::F, ArgType::F_MF, ArgType::F }, &Script::mulf },
-			{ "mulv",	{ ArgType::V, ArgType::F_V_MF, ArgType::V }, &Script::mulv },
-			{ "div",	{ ArgType::I, ArgType::I_MI, ArgType::I }, &Script::div },
-			{ "divf",	{ ArgType::F, ArgType::F_MF, ArgType::F }, &Script::divf },
-			{ "divv",	{ ArgType::V, ArgType::F_V_MF, ArgType::V }, &Script::divv },
-			// math.bit
-			{ "and",	{ ArgType::I, ArgType::I_MI, ArgType::I }, &Script::band },
-			{ "xor",	{ ArgType::I, ArgType::I_MI, ArgType::I }, &Script::bxor },
-			{ "or",		{ ArgType::I, ArgType::I_MI, ArgType::I }, &Script::bor },
-			{ "not",	{ ArgType::I_MI, ArgType::I }, &Script::bnot },
-			{ "sl",		{ ArgType::I, ArgType::I_MI, ArgType::I }, &Script::sl },
-			{ "sr",		{ ArgType::I, ArgType::I_MI, ArgType::I }, &Script::sr },
-			// math.trig
-			{ "sin",		{ ArgType::F, ArgType::F }, &Script::sine },
-			{ "cos",		{ ArgType::F, ArgType::F }, &Script::cosine },
-			{ "tan",		{ ArgType::F, ArgType::F }, &Script::tangent },
-			{ "asin",		{ ArgType::F, ArgType::F }, &Script::arcsine },
-			{ "acos",		{ ArgType::F, ArgType::F }, &Script::arccosine },
-			{ "atan",		{ ArgType::F, ArgType::F }, &Script::arctangent },
-			// math.fn
-			{ "min",	{ ArgType::I, ArgType::I_MI, ArgType::I }, &Script::min },
-			{ "max",	{ ArgType::I, ArgType::I_MI, ArgType::I }, &Script::max },
-			{ "minf",	{ ArgType::F, ArgType::F_MF, ArgType::F }, &Script::minf },
-			{ "maxf",	{ ArgType::F, ArgType::F_MF, ArgType::F }, &Script::maxf },
-			{ "minv",	{ ArgType::V, ArgType::F }, &Script::minv },
-			{ "maxv",	{ ArgType::V, ArgType::F }, &Script::maxv },
-			{ "pow",	{ ArgType::F, ArgType::F_MF, ArgType::F }, &Script::power },
-			{ "sqrt",	{ ArgType::F_MF, ArgType::F }, &Script::squareroot },
-			{ "abs",	{ ArgType::I_MI, ArgType::I }, &Script::absolute },
-			{ "absf",	{ ArgType::F_MF, ArgType::F }, &Script::absolutef },
-			{ "absv",	{ ArgType::V, ArgType::V }, &Script::absolutev },
-			{ "rand",	{ ArgType::I, ArgType::I_MI, ArgType::I }, &Script::random },
-			{ "randf",	{ ArgType::F, ArgType::F_MF, ArgType::F }, &Script::randomf },
-			{ "sign",	{ ArgType::I_MI, ArgType::I }, &Script::sign },
-			{ "signf",	{ ArgType::F_MF, ArgType::F }, &Script::signf },
-			{ "signv",	{ ArgType::V, ArgType::V }, &Script::signv },
-			// math.vec
-			{ "dot",	{ ArgType::V, ArgType::V, ArgType::F }, &Script::dot },
-			{ "mag",	{ ArgType::V, ArgType::F }, &Script::mag },
-			{ "ang",	{ ArgType::V, ArgType::F }, &Script::ang },
-			{ "angv",	{ ArgType::V, ArgType::V, ArgType::F }, &Script::angv },
-			{ "norm",	{ ArgType::V, ArgType::V }, &Script::norm },
-			// mem
-			{ "psh",	{ ArgType::I_F_V }, &Script::psh },
-			{ "pop",	{ ArgType::I_F_V }, &Script::pop },
-			{ "mov",	{ ArgType::I_F_MI, ArgType::I }, &Script::mov },
-			{ "movl",	{ ArgType::I_MI, ArgType::I }, &Script::movl },
-			{ "movh",	{ ArgType::I_MI, ArgType::I }, &Script::movh },
-			{ "movf",	{ ArgType::I_F_MF, ArgType::F }, &Script::movf },
-			{ "movv",	{ ArgType::I_F_V_MF, ArgType::V }, &Script::movv },
-			{ "movx",	{ ArgType::I_F_V_MF, ArgType::V }, &Script::movx },
-			{ "movy",	{ ArgType::I_F_V_MF, ArgType::V }, &Script::movy },
-			{ "stm",	{ ArgType::I_F_V, ArgType::I_MI }, &Script::stm },
-			{ "ldm",	{ ArgType::I_MI, ArgType::I_F_V }, &Script::ldm },
-			// ctrl
-			{ "beq",	{ ArgType::I_F_V, ArgType::I_F_V, ArgType::L_MI }, &Script::beq },
-			{ "beqz",	{ ArgType::I_F_V, ArgType::L_MI }, &Script::beqz },
-			{ "bne",	{ ArgType::I_F_V, ArgType::I_F_V, ArgType::L_MI }, &Script::bne },
-			{ "blt",	{ ArgType::I_F, ArgType::I_F, ArgType::L_MI }, &Script::blt },
-			{ "bgt",	{ ArgType::I_F, ArgType::I_F, ArgType::L_MI }, &Script::bgt },
-			{ "ble",	{ ArgType::I_F, ArgType::I_F, ArgType::L_MI }, &Script::ble },
-			{ "bge",	{ ArgType::I_F, ArgType::I_F, ArgType::L_MI }, &Script::bge },
-			{ "j",		{ ArgType::L_MI }, &Script::j },
-			{ "call",	{ ArgType::L_MI }, &Script::call },
-			{ "ret",	{ }, &Script::ret },
-			{ "end",	{ }, &Script::end },
-			{ "slp",	{ ArgType::I_MI }, &Script::slp },
-			{ "blk",	{ ArgType::I_MI }, &Script::blk },
-			// debug
-			{ "dbg",	{ ArgType::I_MI }, &Script::dbg },
-			{ "dbgf",	{ ArgType::F_MF }, &Script::dbgf },
-			{ "dbgv",	{ ArgType::V }, &Script::dbgv },
-			{ "dbgs",	{ ArgType::I_MI_MS }, &Script::dbgs },
-			// engine
-			{ "time",	{ ArgType::F }, &Script::gettime },
-			// engine.input
-			{ "imp",	{ ArgType::V }, &Script::imp },
-			{ "ims",	{ ArgType::V }, &Script::ims },
-			{ "imb",	{ ArgType::I_MI, ArgType::I }, &Script::imb },
-			{ "ikp",	{ ArgType::I_MI, ArgType::I }, &Script::ikp },
-			{ "ikd",	{ ArgType::I_MI, ArgType::I_MI, ArgType::I }, &Script::ikd },
-			// engine.obj
-			{ "ogp",	{ ArgType::V }, &Script::ogp },
-			{ "osp",	{ ArgType::V }, &Script::osp },
-			{ "ogv",	{ ArgType::V }, &Script::ogv },
-			{ "osv",	{ ArgType::V }, &Script::osv },
-			{ "ogd",	{ ArgType::V }, &Script::ogd },
-			{ "ogs",	{ ArgType::F }, &Script::ogs },
-			{ "oss",	{ ArgType::I_MI_MS }, &Script::oss },
-			{ "spn",	{ ArgType::I_MI_MS, ArgType::I }, &Script::spn }
-		};
+			static_assert(sizeof...(DESC) <= CommandDescription::s_RegCount);
+			constexpr ArgType desc[CommandDescription::s_RegCount] = { DESC... };
+			constexpr uint count = OperandCount(desc[0]) * OperandCount(desc[1]) * OperandCount(desc[2]);
+			static_assert(count <= s_MaxSpecializations);
+			return Specialize<H, desc[0], desc[1], desc[2]>(name, sizeof...(DESC), std::make_index_sequence<count>());
+		}
+		template<typename H, ArgType D0, ArgType D1, ArgType D2, size_t... INDICES>
+		constexpr static Instruction Specialize(const char* name, uint argCount, std::index_sequence<INDICES...>)
+		{
+			constexpr uint n1 = OperandCount(D1), n2 = OperandCount(D2);
+			return { name, { D0, D1, D2 }, argCount, sizeof...(INDICES), { H::template Get<OperandAt(D0, CAST(uint, INDICES / (n1 * n2))), OperandAt(D1, CAST(uint, INDICES / n2 % n1)), OperandAt(D2, CAST(uint, INDICES % n2))>()... } };
+		}
+		constexpr static auto Instructions()
+		{
+			return std::array
+			{
+				// math
+				Specialize<add_t, ArgType::I, ArgType::I_MI, ArgType::I>("add"),
+				Specialize<addf_t, ArgType::F, ArgType::F_MF, ArgType::F>("addf"),
+				Specialize<addv_t, ArgType::V, ArgType::F_V_MF, ArgType::V>("addv"),
+				Specialize<sub_t, ArgType::I, ArgType::I_MI, ArgType::I>("sub"),
+				Specialize<subf_t, ArgType::F, ArgType::F_MF, ArgType::F>("subf"),
+				Specialize<subv_t, ArgType::V, ArgType::F_V_MF, ArgType::V>("subv"),
+				Specialize<mul_t, ArgType::I, ArgType::I_MI, ArgType::I>("mul"),
+				Specialize<mulf_t, ArgType::F, ArgType::F_MF, ArgType::F>("mulf"),
+				Specialize<mulv_t, ArgType::V, ArgType::F_V_MF, ArgType::V>("mulv"),
+				Specialize<div_t, ArgType::I, ArgType::I_MI, ArgType::I>("div"),
+				Specialize<divf_t, ArgType::F, ArgType::F_MF, ArgType::F>("divf"),
+				Specialize<divv_t, ArgType::V, ArgType::F_V_MF, ArgType::V>("divv"),
+				// math.bit
+				Specialize<band_t, ArgType::I, ArgType::I_MI, ArgType::I>("and"),
+				Specialize<bxor_t, ArgType::I, ArgType::I_MI, ArgType::I>("xor"),
+				Specialize<bor_t, ArgType::I, ArgType::I_MI, ArgType::I>("or"),
+				Specialize<bnot_t, ArgType::I_MI, ArgType::I>("not"),
+				Specialize<sl_t, ArgType::I, ArgType::I_MI, ArgType::I>("sl"),
+				Specialize<sr_t, ArgType::I, ArgType::I_MI, ArgType::I>("sr"),
+				// math.trig
+				Specialize<sine_t, ArgType::F, ArgType::F>("sin"),
+				Specialize<cosine_t, ArgType::F, ArgType::F>("cos"),
+				Specialize<tangent_t, ArgType::F, ArgType::F>("tan"),
+				Specialize<arcsine_t, ArgType::F, ArgType::F>("asin"),
+				Specialize<arccosine_t, ArgType::F, ArgType::F>("acos"),
+				Specialize<arctangent_t, ArgType::F, ArgType::F, ArgType::F>("atan"),
+				// math.fn
+				Specialize<min_t, ArgType::I, ArgType::I_MI, ArgType::I>("min"),
+				Specialize<max_t, ArgType::I, ArgType::I_MI, ArgType::I>("max"),
+				Specialize<minf_t, ArgType::F, ArgType::F_MF, ArgType::F>("minf"),
+				Specialize<maxf_t, ArgType::F, ArgType::F_MF, ArgType::F>("maxf"),
+				Specialize<minv_t, ArgType::V, ArgType::F>("minv"),
+				Specialize<maxv_t, ArgType::V, ArgType::F>("maxv"),
+				Specialize<power_t, ArgType::F, ArgType::F_MF, ArgType::F>("pow"),
+				Specialize<squareroot_t, ArgType::F_MF, ArgType::F>("sqrt"),
+				Specialize<absolute_t, ArgType::I_MI, ArgType::I>("abs"),
+				Specialize<absolutef_t, ArgType::F_MF, ArgType::F>("absf"),
+				Specialize<absolutev_t, ArgType::V, ArgType::V>("absv"),
+				Specialize<random_t, ArgType::I, ArgType::I_MI, ArgType::I>("rand"),
+				Specialize<randomf_t, ArgType::F, ArgType::F_MF, ArgType::F>("randf"),
+				Specialize<sign_t, ArgType::I_MI, ArgType::I>("sign"),
+				Specialize<signf_t, ArgType::F_MF, ArgType::F>("signf"),
+				Specialize<signv_t, ArgType::V, ArgType::V>("signv"),
+				// math.vec
+				Specialize<dot_t, ArgType::V, ArgType::V, ArgType::F>("dot"),
+				Specialize<mag_t, ArgType::V, ArgType::F>("mag"),
+				Specialize<ang_t, ArgType::V, ArgType::F>("ang"),
+				Specialize<angv_t, ArgType::V, ArgType::V, ArgType::F>("angv"),
+				Specialize<norm_t, ArgType::V, ArgType::V>("norm"),
+				// mem
+				Specialize<psh_t, ArgType::I_F_V>("psh"),
+				Specialize<pop_t, ArgType::I_F_V>("pop"),
+				Specialize<mov_t, ArgType::I_F_MI, ArgType::I>("mov"),
+				Specialize<movl_t, ArgType::I_MI, ArgType::I>("movl"),
+				Specialize<movh_t, ArgType::I_MI, ArgType::I>("movh"),
+				Specialize<movf_t, ArgType::I_F_MF, ArgType::F>("movf"),
+				Specialize<movv_t, ArgType::I_F_V_MF, ArgType::V>("movv"),
+				Specialize<movx_t, ArgType::I_F_V_MF, ArgType::V>("movx"),
+				Specialize<movy_t, ArgType::I_F_V_MF, ArgType::V>("movy"),
+				Specialize<stm_t, ArgType::I_F_V, ArgType::I_MI>("stm"),
+				Specialize<ldm_t, ArgType::I_MI, ArgType::I_F_V>("ldm"),
+				// ctrl
+				Specialize<beq_t, ArgType::I_F_V, ArgType::I_F_V, ArgType::L_MI>("beq"),
+				Specialize<beqz_t, ArgType::I_F_V, ArgType::L_MI>("beqz"),
+				Specialize<bne_t, ArgType::I_F_V, ArgType::I_F_V, ArgType::L_MI>("bne"),
+				Specialize<blt_t, ArgType::I_F, ArgType::I_F, ArgType::L_MI>("blt"),
+				Specialize<bgt_t, ArgType::I_F, ArgType::I_F, ArgType::L_MI>("bgt"),
+				Specialize<ble_t, ArgType::I_F, ArgType::I_F, ArgType::L_MI>("ble"),
+				Specialize<bge_t, ArgType::I_F, ArgType::I_F, ArgType::L_MI>("bge"),
+				Specialize<j_t, ArgType::L_MI>("j"),
+				Specialize<call_t, ArgType::L_MI>("call"),
+				Specialize<ret_t>("ret"),
+				Specialize<end_t>("end"),
+				Specialize<slp_t, ArgType::I_MI>("slp"),
+				Specialize<blk_t, ArgType::I_MI>("blk"),
+				// debug
+				Specialize<dbg_t, ArgType::I_MI>("dbg"),
+				Specialize<dbgf_t, ArgType::F_MF>("dbgf"),
+				Specialize<dbgv_t, ArgType::V>("dbgv"),
+				Specialize<dbgs_t, ArgType::I_MI_MS>("dbgs"),
+				// engine
+				Specialize<gettime_t, ArgType::F>("time"),
+				// engine.input
+				Specialize<imp_t, ArgType::V>("imp"),
+				Specialize<ims_t, ArgType::V>("ims"),
+				Specialize<imb_t, ArgType::I_MI, ArgType::I>("imb"),
+				Specialize<ikp_t, ArgType::I_MI, ArgType::I>("ikp"),
+				Specialize<ikd_t, ArgType::I_MI, ArgType::I_MI, ArgType::I>("ikd"),
+				// engine.obj
+				Specialize<ogp_t, ArgType::V>("ogp"),
+				Specialize<osp_t, ArgType::V>("osp"),
+				Specialize<ogv_t, ArgType::V>("ogv"),
+				Specialize<osv_t, ArgType::V>("osv"),
+				Specialize<ogd_t, ArgType::V>("ogd"),
+				Specialize<ogs_t, ArgType::F>("ogs"),
+				Specialize<oss_t, ArgType::I_MI_MS>("oss"),
+				Specialize<ogc_t, ArgType::I>("ogc"),
+				Specialize<osc_t, ArgType::I_MI>("osc"),
+				Specialize<ogm_t, ArgType::I>("ogm"),
+				Specialize<osm_t, ArgType::I_MI>("osm"),
+				Specialize<otp_t, ArgType::I_MI_MS, ArgType::I>("otp"),
+				Specialize<otn_t, ArgType::I, ArgType::I>("otn"),
+				Specialize<spn_t, ArgType::I_MI_MS, ArgType::I>("spn"),
+				// engine.world
+				Specialize<wsp_t, ArgType::V, ArgType::I>("wsp"),
+				Specialize<wsr_t, ArgType::V, ArgType::V, ArgType::I>("wsr"),
+				Specialize<wti_t, ArgType::I_MI_MS, ArgType::I>("wti")
+			};
+		}
+		constexpr static uint HandlerCount()
+		{
+			uint count = 0;
+			for (const Instruction& instruction : Instructions())
+				count += instruction.opCount;
+			return count;
+		}
+		// every instruction's handlers back to back, Args::handler indexes into this
+		constexpr static auto Handlers()
+		{
+			constexpr auto instructions = Instructions();
+			std::array<Operation, HandlerCount()> handlers = {};
+			uint next = 0;
+			for (const Instruction& instruction : instructions)
+				for (uint i = 0; i < instruction.opCount; i++)
+					handlers[next++] = instruction.ops[i];
+			return handlers;
+		}
+		// Changes whenever the instruction set does, since that changes what Args::handler means. Saved bytecode is only used if this matches (see ScriptProgram).
+		constexpr static ulong Fingerprint()
+		{
+			ulong hash = math::fnv1a(nullptr, 0);
+			for (const Instruction& instruction : Instructions())
+			{
+				size_t length = 0;
+				while (instruction.name[length])
+					length++;
+				hash = math::fnv1a(instruction.name, length + 1, hash);
+				// these all fit in a byte
+				const char layout[] = { CAST(char, instruction.argCount), CAST(char, instruction.opCount), CAST(char, instruction.desc[0]), CAST(char, instruction.desc[1]), CAST(char, instruction.desc[2]) };
+				hash = math::fnv1a(layout, sizeof(layout), hash);
+			}
+			// the optimizer changes what gets saved too
+			const char args[] = { CAST(char, sizeof(Args)), CAST(char, s_ScriptOptimize), CAST(char, ScriptOptimizer::s_Version) };
+			return math::fnv1a(args, sizeof(args), hash);
+		}
 	};
 }
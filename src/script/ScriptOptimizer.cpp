@@ -0,0 +1,466 @@
+#include "pch.h"
+#include "ScriptOptimizer.h"
+#include "ScriptProgram.h"
+#include "Script.h"
+
+namespace engine
+{
+	ScriptOptimizer::ScriptOptimizer(ScriptProgram* const program) :
+		m_Program(program),
+		m_EntryPoint(program->m_EntryPoint),
+		m_Effects(Script::s_CommandNames.size(), Effect::OTHER)
+	{
+		for (const Args& args : program->m_Instructions)
+			m_Code.push_back({ args, Script::s_HandlerDescriptions[args.handler] });
+
+		const auto opcode = [](const char* name) { return Script::s_CommandDescriptions.at(name).opcode; };
+		// rand isn't here since it doesn't give the same thing every time
+		for (const char* name : { "add", "sub", "mul", "div", "and", "xor", "or", "not", "sl", "sr", "min", "max", "abs", "sign",
+			"addf", "subf", "mulf", "divf", "minf", "maxf", "pow", "sqrt", "absf", "signf", "sin", "cos", "tan", "asin", "acos", "atan",
+			"addv", "subv", "mulv", "divv", "minv", "maxv", "absv", "signv", "dot", "mag", "ang", "angv", "norm",
+			"mov", "movl", "movh", "movf", "movv" })
+			m_Effects[opcode(name)] = Effect::PURE;
+		for (const char* name : { "beq", "beqz", "bne", "blt", "bgt", "ble", "bge" })
+			m_Effects[opcode(name)] = Effect::BRANCH;
+		m_Effects[opcode("j")] = Effect::JUMP;
+		m_Effects[opcode("call")] = Effect::CALL;
+		m_Effects[opcode("ret")] = Effect::RET;
+		m_Effects[opcode("end")] = Effect::END;
+		m_Effects[opcode("slp")] = Effect::SLEEP;
+		m_Effects[opcode("psh")] = Effect::STACK;
+		m_Effects[opcode("pop")] = Effect::STACK;
+		m_Mov = opcode("mov");
+		m_Movf = opcode("movf");
+		m_Movv = opcode("movv");
+		m_Movl = opcode("movl");
+		m_Movh = opcode("movh");
+		m_Div = opcode("div");
+		m_Sl = opcode("sl");
+		m_Sr = opcode("sr");
+	}
+
+
+
+	void ScriptOptimizer::Optimize()
+	{
+		if constexpr (s_ScriptOptimizerDump)
+			Dump("before");
+
+		const size_t before = m_Code.size();
+		const uint inlined = InlineCalls();
+		const uint threaded = ThreadJumps();
+		const uint forwarded = ForwardCopies();
+		const uint folded = FoldConstants();
+		const uint removed = RemoveDeadStores();
+
+		m_Program->m_Instructions.clear();
+		for (const Node& node : m_Code)
+			m_Program->m_Instructions.push_back(node.args);
+		m_Program->m_EntryPoint = m_EntryPoint;
+
+		if constexpr (s_ScriptOptimizerDump)
+		{
+			Dump("after");
+			printf("[%s]: %zu -> %zu instructions (%u calls inlined, %u jumps threaded, %u copies forwarded, %u constants folded, %u dead stores removed)\n", m_Program->GetFilepath().c_str(), before, m_Code.size(), inlined, threaded, forwarded, folded, removed);
+		}
+	}
+
+
+
+	uint ScriptOptimizer::GetDest(const Node& node) const
+	{
+		uint last = 0;
+		for (uint i = 0; i < CommandDescription::s_RegCount; i++)
+			if (node.desc.operands[i] != Operand::NONE)
+				last = i;
+		return last;
+	}
+	bool ScriptOptimizer::Reads(const Node& node, Operand kind, uint reg) const
+	{
+		// movl and movh only replace half of what's there
+		const uint dest = GetDest(node);
+		const bool partial = node.desc.opcode == m_Movl || node.desc.opcode == m_Movh;
+		for (uint i = 0; i < CommandDescription::s_RegCount; i++)
+			if ((i != dest || partial) && node.desc.operands[i] == kind && node.args.reg[i] == reg)
+				return true;
+		return false;
+	}
+	int ScriptOptimizer::GetSlot(Operand kind, uint reg) const
+	{
+		// the special int registers are the last ones, starting at $obj
+		static_assert(Registers::s_RegObj < Registers::s_RegHost && Registers::s_RegObj < Registers::s_RegObjCount && Registers::s_RegObj < Registers::s_RegFlags);
+		if (kind == Operand::I)
+			return reg < Registers::s_RegObj ? CAST(int, reg) : -1;
+		if (kind == Operand::F)
+			return CAST(int, Registers::s_RegObj + reg);
+		return -1;
+	}
+	std::vector<bool> ScriptOptimizer::GetLeaders() const
+	{
+		std::vector<bool> leaders(m_Code.size() + 1, false);
+		leaders[0] = true;
+		if (m_EntryPoint < leaders.size())
+			leaders[m_EntryPoint] = true;
+		for (const Node& node : m_Code)
+			if (HasTarget(node) && node.args.imm1i >= 0 && node.args.imm1i < CAST(int64_t, m_Code.size()))
+				leaders[node.args.imm1i] = true;
+		return leaders;
+	}
+	void ScriptOptimizer::Rebuild(std::vector<Node>&& code, const std::vector<uint>& map)
+	{
+		const int64_t oldSize = CAST(int64_t, map.size() - 1), newSize = CAST(int64_t, code.size());
+		// out of range targets stay out of range, so they still fail the same way when they're taken
+		const auto remap = [&](int64_t target)
+		{
+			if (target < 0)
+				return target;
+			return target <= oldSize ? CAST(int64_t, map[target]) : target - oldSize + newSize;
+		};
+		for (Node& node : code)
+			if (HasTarget(node))
+				node.args.imm1i = remap(node.args.imm1i);
+		m_EntryPoint = CAST(uint, remap(m_EntryPoint));
+		m_Code = std::move(code);
+	}
+	ScriptOptimizer::Node ScriptOptimizer::MakeStore(const Node& node, int64_t i, double f) const
+	{
+		const uint dest = GetDest(node);
+		const bool isInt = node.desc.operands[dest] == Operand::I;
+		Node store = { {}, { isInt ? m_Mov : m_Movf, { isInt ? Operand::MI : Operand::MF, isInt ? Operand::I : Operand::F, Operand::NONE } } };
+		if (isInt)
+			store.args.imm1i = i;
+		else
+			store.args.imm1f = f;
+		store.args.reg[1] = node.args.reg[dest];
+		store.args.handler = CAST(ushort, Script::HandlerIndex(Script::s_CommandDescriptions.at(Script::s_CommandNames.at(store.desc.opcode)), store.desc.operands));
+		return store;
+	}
+
+
+
+	uint ScriptOptimizer::InlineCalls()
+	{
+		std::vector<Node> code;
+		std::vector<uint> map;
+		uint count = 0;
+		for (const Node& node : m_Code)
+		{
+			map.push_back(CAST(uint, code.size()));
+			if (GetEffect(node) != Effect::CALL || node.args.imm1i < 0 || node.args.imm1i >= CAST(int64_t, m_Code.size()))
+			{
+				code.push_back(node);
+				continue;
+			}
+
+			// the function has to be a short straight line that ends in a ret
+			std::vector<Node> body;
+			bool inlinable = false;
+			for (size_t i = CAST(size_t, node.args.imm1i); i < m_Code.size() && body.size() <= s_InlineLimit; i++)
+			{
+				const Effect effect = GetEffect(m_Code[i]);
+				if (effect == Effect::RET)
+				{
+					inlinable = body.size() <= s_InlineLimit;
+					break;
+				}
+				if (IsControl(m_Code[i]) || effect == Effect::STACK)
+					break;
+				body.push_back(m_Code[i]);
+			}
+
+			if (!inlinable)
+			{
+				code.push_back(node);
+				continue;
+			}
+			code.insert(code.end(), body.begin(), body.end());
+			count++;
+		}
+		map.push_back(CAST(uint, code.size()));
+
+		if (count)
+			Rebuild(std::move(code), map);
+		return count;
+	}
+	uint ScriptOptimizer::ThreadJumps()
+	{
+		const int64_t size = CAST(int64_t, m_Code.size());
+		const auto inRange = [&](int64_t target) { return target >= 0 && target < size; };
+		uint count = 0;
+		for (Node& node : m_Code)
+		{
+			if (!HasTarget(node))
+				continue;
+
+			// follow j's to wherever they finally go (a loop of them just stops after going all the way around)
+			int64_t target = node.args.imm1i;
+			for (int64_t hops = 0; inRange(target) && GetEffect(m_Code[target]) == Effect::JUMP && hops < size; hops++)
+				target = m_Code[target].args.imm1i;
+			if (target != node.args.imm1i)
+			{
+				node.args.imm1i = target;
+				count++;
+			}
+
+			// a j to a ret or end might as well be one
+			if (GetEffect(node) == Effect::JUMP && inRange(target) && (GetEffect(m_Code[target]) == Effect::RET || GetEffect(m_Code[target]) == Effect::END))
+			{
+				node = m_Code[target];
+				count++;
+			}
+		}
+
+		// j's and branches to the very next instruction don't do anything
+		std::vector<Node> code;
+		std::vector<uint> map;
+		for (int64_t i = 0; i < size; i++)
+		{
+			map.push_back(CAST(uint, code.size()));
+			const Effect effect = GetEffect(m_Code[i]);
+			if ((effect == Effect::JUMP || effect == Effect::BRANCH) && m_Code[i].args.imm1i == i + 1 && i + 1 < size)
+			{
+				count++;
+				continue;
+			}
+			code.push_back(m_Code[i]);
+		}
+		map.push_back(CAST(uint, code.size()));
+		Rebuild(std::move(code), map);
+		return count;
+	}
+	uint ScriptOptimizer::ForwardCopies()
+	{
+		// A copy of a into b, where the very next instruction reads b and then overwrites all of it, can just read a instead. For example, movv $v0, $v2 then mulv $v2, .5, $v2 is just mulv $v0, .5, $v2.
+		const std::vector<bool> leaders = GetLeaders();
+		std::vector<Node> code;
+		std::vector<uint> map;
+		uint count = 0;
+		for (size_t i = 0; i < m_Code.size(); i++)
+		{
+			map.push_back(CAST(uint, code.size()));
+			const Node& copy = m_Code[i];
+			const Operand kind = copy.desc.operands[1];
+			const bool isCopy = (copy.desc.opcode == m_Mov || copy.desc.opcode == m_Movf || copy.desc.opcode == m_Movv) && copy.desc.operands[0] == kind;
+			if (!isCopy || (kind == Operand::I && copy.args.reg[1] >= Registers::s_RegObj) || i + 1 >= m_Code.size() || leaders[i + 1] || GetEffect(m_Code[i + 1]) != Effect::PURE)
+			{
+				code.push_back(copy);
+				continue;
+			}
+
+			Node next = m_Code[i + 1];
+			const uint dest = GetDest(next);
+			const uint from = copy.args.reg[0], to = copy.args.reg[1];
+			const bool overwrites = next.desc.operands[dest] == kind && next.args.reg[dest] == to && next.desc.opcode != m_Movl && next.desc.opcode != m_Movh;
+			if (!overwrites || !Reads(next, kind, to))
+			{
+				code.push_back(copy);
+				continue;
+			}
+
+			// same kinds of operands, so the handler doesn't change
+			for (uint j = 0; j < CommandDescription::s_RegCount; j++)
+				if (j != dest && next.desc.operands[j] == kind && next.args.reg[j] == to)
+					next.args.reg[j] = CAST(uchar, from);
+			code.push_back(next);
+			map.push_back(CAST(uint, code.size()) - 1);
+			i++;
+			count++;
+		}
+		map.push_back(CAST(uint, code.size()));
+
+		if (count)
+			Rebuild(std::move(code), map);
+		return count;
+	}
+	uint ScriptOptimizer::FoldConstants()
+	{
+		struct Value
+		{
+			bool known;
+			int64_t i;
+			double f;
+		};
+		constexpr static auto handlers = Script::Handlers();
+		std::vector<Value> values(Registers::s_RegObj + Registers::s_FloatRegCount, { false, 0, 0. });
+		const auto forget = [&]()
+		{
+			for (Value& value : values)
+				value.known = false;
+		};
+		// runs the real handler, so that the result is exactly what running it would give
+		Script* const scratch = new Script(CAST(const ScriptProgram*, m_Program));
+		std::vector<Scriptable*> env;
+
+		const std::vector<bool> leaders = GetLeaders();
+		uint count = 0;
+		for (size_t i = 0; i < m_Code.size(); i++)
+		{
+			if (leaders[i])
+				forget();
+			Node& node = m_Code[i];
+			const Effect effect = GetEffect(node);
+			if (effect != Effect::PURE)
+			{
+				// anything it names might have been written
+				for (uint j = 0; j < CommandDescription::s_RegCount; j++)
+				{
+					const int slot = GetSlot(node.desc.operands[j], node.args.reg[j]);
+					if (slot != -1)
+						values[slot].known = false;
+				}
+				// only a branch falls through to the next instruction with everything still the same
+				if (IsControl(node) && effect != Effect::BRANCH)
+					forget();
+				continue;
+			}
+
+			const uint dest = GetDest(node);
+			const int destSlot = GetSlot(node.desc.operands[dest], node.args.reg[dest]);
+			// every register it reads has to be known
+			bool foldable = destSlot != -1;
+			for (uint j = 0; j < CommandDescription::s_RegCount && foldable; j++)
+			{
+				const Operand kind = node.desc.operands[j];
+				if (kind == Operand::NONE || IsImmediate(kind) || !Reads(node, kind, node.args.reg[j]))
+					continue;
+				const int slot = GetSlot(kind, node.args.reg[j]);
+				if (slot == -1 || !values[slot].known)
+				{
+					foldable = false;
+					break;
+				}
+				if (kind == Operand::I)
+					scratch->m_Registers.i[node.args.reg[j]] = values[slot].i;
+				else
+					scratch->m_Registers.f[node.args.reg[j]] = values[slot].f;
+			}
+			// these would crash (or be undefined) when they're folded, so leave them to do that at runtime
+			if (foldable && (node.desc.opcode == m_Div || node.desc.opcode == m_Sl || node.desc.opcode == m_Sr))
+			{
+				const int64_t rhs = node.desc.operands[1] == Operand::MI ? node.args.imm1i : scratch->m_Registers.i[node.args.reg[1]];
+				const int64_t lhs = scratch->m_Registers.i[node.args.reg[0]];
+				if (node.desc.opcode == m_Div ? (rhs == 0 || (rhs == -1 && lhs == INT64_MIN)) : (rhs < 0 || rhs > 63))
+					foldable = false;
+			}
+			if (!foldable)
+			{
+				if (destSlot != -1)
+					values[destSlot].known = false;
+				continue;
+			}
+
+			(scratch->*handlers[node.args.handler])(node.args, 0.f, 0.f, nullptr, nullptr, env);
+			Value& value = values[destSlot];
+			value.known = true;
+			value.i = scratch->m_Registers.i[node.args.reg[dest]];
+			value.f = scratch->m_Registers.f[node.args.reg[dest]];
+			// already as simple as it gets
+			if ((node.desc.opcode == m_Mov && node.desc.operands[0] == Operand::MI) || (node.desc.opcode == m_Movf && node.desc.operands[0] == Operand::MF))
+				continue;
+			node = MakeStore(node, value.i, value.f);
+			count++;
+		}
+
+		delete scratch;
+		return count;
+	}
+	uint ScriptOptimizer::RemoveDeadStores()
+	{
+		const std::vector<bool> leaders = GetLeaders();
+		std::vector<Node> code;
+		std::vector<uint> map;
+		uint count = 0;
+		for (size_t i = 0; i < m_Code.size(); i++)
+		{
+			map.push_back(CAST(uint, code.size()));
+			const Node& node = m_Code[i];
+			if (GetEffect(node) != Effect::PURE)
+			{
+				code.push_back(node);
+				continue;
+			}
+
+			// Dead if another PURE instruction overwrites it before anything reads it. Anything else could read it, or end the run (even by failing) and leave it there for next time.
+			const uint dest = GetDest(node);
+			const Operand kind = node.desc.operands[dest];
+			const uint reg = node.args.reg[dest];
+			bool dead = false;
+			for (size_t j = i + 1; GetSlot(kind, reg) != -1 && j < m_Code.size() && !leaders[j] && GetEffect(m_Code[j]) == Effect::PURE; j++)
+			{
+				if (Reads(m_Code[j], kind, reg))
+					break;
+				const uint other = GetDest(m_Code[j]);
+				if (m_Code[j].desc.operands[other] == kind && m_Code[j].args.reg[other] == reg)
+				{
+					dead = true;
+					break;
+				}
+			}
+
+			if (dead)
+			{
+				count++;
+				continue;
+			}
+			code.push_back(node);
+		}
+		map.push_back(CAST(uint, code.size()));
+
+		if (count)
+			Rebuild(std::move(code), map);
+		return count;
+	}
+
+
+
+	void ScriptOptimizer::Dump(const char* title) const
+	{
+		printf("[%s] %s:\n", m_Program->GetFilepath().c_str(), title);
+		for (size_t i = 0; i < m_Code.size(); i++)
+		{
+			const Node& node = m_Code[i];
+			std::string line = Script::s_CommandNames.at(node.desc.opcode);
+			// immediates are stored in the order they were given
+			bool second = false;
+			for (uint j = 0; j < CommandDescription::s_RegCount; j++)
+			{
+				const Operand kind = node.desc.operands[j];
+				if (kind == Operand::NONE)
+					break;
+				line += (j == 0 ? "\t" : ", ");
+				if (kind == Operand::MI)
+					line += (HasTarget(node) ? "@" : "") + std::to_string(second ? node.args.imm2i : node.args.imm1i);
+				else if (kind == Operand::MF)
+					line += std::to_string(node.args.imm1f);
+				else
+					line += GetRegisterName(kind, node.args.reg[j]);
+				second |= IsImmediate(kind);
+			}
+			printf("%c%4zu: %s\n", i == m_EntryPoint ? '>' : ' ', i, line.c_str());
+		}
+	}
+	std::string ScriptOptimizer::GetRegisterName(Operand kind, uint reg) const
+	{
+		// find the index in the script's numbering that maps to reg, then name it the way a script would
+		for (const auto& [name, index] : Script::s_SpecialRegisters)
+			if (kind == Operand::I && Script::GetIntRegister(CAST(uint, index)) == CAST(int, reg))
+				return name;
+		for (uint index = 0; index < 64; index++)
+		{
+			const int mapped = kind == Operand::I ? Script::GetIntRegister(index) : (kind == Operand::F ? Script::GetFloatRegister(index) : Script::GetVecRegister(index));
+			if (mapped != CAST(int, reg))
+				continue;
+
+			char group = '?';
+			int64_t offset = 0;
+			for (const auto& [c, start] : Script::s_RegisterOffsets)
+				if (start <= index && start >= offset)
+				{
+					group = c;
+					offset = start;
+				}
+			return std::string("$") + group + std::to_string(index - offset);
+		}
+		return "$?";
+	}
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include "pch.h"
+#include "Command.h"
+
+namespace engine
+{
+	class ScriptProgram;
+
+	// Rewrites a freshly parsed ScriptProgram to do the same thing in fewer instructions. Every pass only looks within straight-line runs of code, and never touches the special registers ($obj, $hst, $oc, $flags), since object ops read those without naming them. Registers keep their values between runs of a Script, so a store is only ever dropped if something overwrites it before the run could end.
+	class ScriptOptimizer
+	{
+	public:
+		ScriptOptimizer(ScriptProgram* const program);
+		ScriptOptimizer(const ScriptOptimizer& other) = delete;
+		ScriptOptimizer(ScriptOptimizer&& other) = delete;
+
+
+		// part of Script::Fingerprint, so bytecode saved by an older optimizer isn't loaded. Bump it whenever a pass (or s_InlineLimit) changes what it outputs.
+		constexpr static uchar s_Version = 1;
+
+
+		// Inlines calls to small leaf functions, threads jumps through other jumps, skips copies that are only used once right after, folds arithmetic on registers that are known to be constant, and removes stores that are overwritten before they're read. Labels have to be resolved already. Prints the program before and after if s_ScriptOptimizerDump.
+		void Optimize();
+	private:
+		// most instructions (not counting its ret) a function can have and still be inlined
+		constexpr static uint s_InlineLimit = 4;
+		struct Node
+		{
+			Args args;
+			HandlerDescription desc;
+		};
+		// what an instruction does, as far as the optimizer cares
+		enum class Effect
+		{
+			// some other effect, or one we don't know about. Any register it names might be read or written.
+			OTHER,
+			// only writes its last operand, from its other operands (and its last one for movl/movh). Nothing else happens.
+			PURE,
+			// conditional branch, j, or call, with its target in imm1i
+			BRANCH, JUMP, CALL,
+			// the run (or function) ends here, or picks back up somewhere else
+			RET, END, SLEEP,
+			// psh/pop, which would see the return address of a call (and are otherwise OTHER)
+			STACK
+		};
+
+
+		ScriptProgram* const m_Program;
+		std::vector<Node> m_Code;
+		uint m_EntryPoint;
+		// indexed by opcode
+		std::vector<Effect> m_Effects;
+		uchar m_Mov, m_Movf, m_Movv, m_Movl, m_Movh, m_Div, m_Sl, m_Sr;
+
+
+		Effect GetEffect(const Node& node) const
+		{
+			return m_Effects[node.desc.opcode];
+		}
+		bool HasTarget(const Node& node) const
+		{
+			const Effect effect = GetEffect(node);
+			return effect == Effect::BRANCH || effect == Effect::JUMP || effect == Effect::CALL;
+		}
+		// where control might not just fall through to the next instruction
+		bool IsControl(const Node& node) const
+		{
+			const Effect effect = GetEffect(node);
+			return effect != Effect::OTHER && effect != Effect::PURE && effect != Effect::STACK;
+		}
+		// operand a PURE instruction writes
+		uint GetDest(const Node& node) const;
+		// whether a PURE instruction reads the given register (as opposed to just writing it)
+		bool Reads(const Node& node, Operand kind, uint reg) const;
+		// index of a register in the arrays that FoldConstants and RemoveDeadStores keep, or -1 for vecs and special registers
+		int GetSlot(Operand kind, uint reg) const;
+		// instructions that something other than the one before them can go to
+		std::vector<bool> GetLeaders() const;
+		// Replaces m_Code with code, where map[i] is where old instruction i ended up (or whatever came after it, if it's gone). Every target and the entry point are moved to match.
+		void Rebuild(std::vector<Node>&& code, const std::vector<uint>& map);
+		// replacement for a PURE instruction that just stores value in the register it writes
+		Node MakeStore(const Node& node, int64_t i, double f) const;
+		uint InlineCalls();
+		uint ThreadJumps();
+		uint ForwardCopies();
+		uint FoldConstants();
+		uint RemoveDeadStores();
+		void Dump(const char* title) const;
+		std::string GetRegisterName(Operand kind, uint reg) const;
+	};
+}
@@ -1,16 +1,17 @@
 #include "pch.h"
 #include "ScriptParser.h"
 #include "Script.h"
+#include "ScriptProgram.h"
+#include "ScriptOptimizer.h"
 
 namespace engine
 {
-	ScriptParser::ScriptParser(const char* fp, Script* const script) :
-		m_LastStringWrite(Script::s_MemCount),
+	ScriptParser::ScriptParser(const char* fp, ScriptProgram* const program) :
 		m_Line(0),
 		m_Filepath(fp),
 		m_File(fp),
 		m_Abort(false),
-		m_Script(script)
+		m_Program(program)
 	{
 		if (!m_File.is_open())
 		{
@@ -50,14 +51,17 @@ namespace engine
 					m_Abort = true;
 					break;
 				}
-				m_Script->m_Instructions[ref.first].imm1i = it->second;
+				m_Program->m_Instructions[ref.first].imm1i = it->second;
 			}
 		}
 
 		// if a "main" label is provided, use it as the entry point
 		const auto& it = m_Labels.find(s_EntryPointToken);
 		if (it != m_Labels.end())
-			m_Script->m_EntryPoint = it->second;
+			m_Program->m_EntryPoint = it->second;
+
+		if (s_ScriptOptimize && !m_Abort)
+			ScriptOptimizer(m_Program).Optimize();
 
 		return !m_Abort;
 	}
@@ -101,12 +105,12 @@ namespace engine
 				return;
 			}
 			
-			m_Labels.emplace(label, CAST(uint, m_Script->m_Instructions.size()));
+			m_Labels.emplace(label, CAST(uint, m_Program->m_Instructions.size()));
 			return;
 		}
 
 		// otherwise, this line is an instruction
-		m_Script->m_Instructions.emplace_back(Create(command, args));
+		m_Program->m_Instructions.emplace_back(Create(command, args));
 	}
 	Args ScriptParser::Create(const std::string& command, const std::string& arglist)
 	{
@@ -119,7 +123,6 @@ namespace engine
 			Err(m_Line, "Invalid command '%'s", command.c_str());
 			return args;
 		}
-		args.opcode = description->second.opcode;
 
 		// make sure given arguments are valid
 		const auto& expected = description->second.args;
@@ -142,12 +145,17 @@ namespace engine
 
 		// parse each argument in the list
 		uint micount = 0;
+		Operand operands[CommandDescription::s_RegCount] = { Operand::NONE, Operand::NONE, Operand::NONE };
 		for (uint i = 0; i < list.size(); i++)
 		{
 			ArgType cur = GetArgType(list[i]);
+			operands[i] = ToOperand(cur);
 			// this argument is a label reference, it must be resolved at the end of parsing
 			if (cur == ArgType::L)
+			{
+				micount++;
 				continue;
+			}
 
 			// convert this argument into an int
 			auto result = ResolveInt(list[i]);
@@ -157,7 +165,15 @@ namespace engine
 			{
 				if (!result.second)
 				{
-					(micount == 0 ? args.imm1i : args.imm2i) = result.first;
+					if (micount == 0)
+						args.imm1i = result.first;
+					else if (result.first == CAST(int16_t, result.first))
+						args.imm2i = CAST(int16_t, result.first);
+					else
+					{
+						Err(m_Line, "Second immediate for instruction '%s' must fit in 16 bits", command.c_str());
+						return args;
+					}
 					micount++;
 				}
 				// result.second being set indicates that the returned "integer" is actually a float
@@ -167,16 +183,25 @@ namespace engine
 			// this argument is a register
 			else
 			{
-				// get a register pointer from the returned register index
+				// get a register from the returned register index
+				int reg = -1;
 				if (cur == ArgType::I)
-					args.i[i] = m_Script->GetIntRegister(CAST(uint, result.first));
+					reg = Script::GetIntRegister(CAST(uint, result.first));
 				else if (cur == ArgType::F)
-					args.f[i] = m_Script->GetFloatRegister(CAST(uint, result.first));
+					reg = Script::GetFloatRegister(CAST(uint, result.first));
 				else
-					args.v[i] = m_Script->GetVecRegister(CAST(uint, result.first));
+					reg = Script::GetVecRegister(CAST(uint, result.first));
+				if (reg == -1)
+				{
+					Err(m_Line, "Invalid register '%s'", list[i].c_str());
+					return args;
+				}
+				args.reg[i] = CAST(uchar, reg);
 			}
 		}
 
+		// the handler for exactly these kinds of operands
+		args.handler = CAST(ushort, Script::HandlerIndex(description->second, operands));
 		return args;
 	}
 	ArgType ScriptParser::GetArgType(const std::string& arg)
@@ -188,7 +213,7 @@ namespace engine
 		// label reference
 		if (std::isalpha(arg[0]))
 		{
-			m_References.emplace(CAST(uint, m_Script->m_Instructions.size()), arg);
+			m_References.emplace(CAST(uint, m_Program->m_Instructions.size()), arg);
 			return ArgType::L;
 		}
 
@@ -240,13 +265,18 @@ namespace engine
 				Err(m_Line, "String literals must be enclosed in '\"'");
 				return { 0, false };
 			}
-			// write string into RAM
+			// write string into RAM, below the ones before it
 			const uint length = CAST(uint, arg.size() - 1);
-			m_LastStringWrite = m_LastStringWrite - length;
-			for (uint i = 0; i < length; i++)
-				m_Script->m_Memory[m_LastStringWrite + i] = (i == length - 1 ? 0 : arg[i + 1]);
+			if (length > m_Program->m_DataStart)
+			{
+				Err(m_Line, "Out of memory for string literals");
+				return { 0, false };
+			}
+			m_Program->m_DataStart -= length;
+			m_Program->m_Data.insert(m_Program->m_Data.begin(), arg.begin() + 1, arg.end());
+			m_Program->m_Data[length - 1] = 0;
 			// return pointer to the string
-			return { CAST(int64_t, m_LastStringWrite), false };
+			return { CAST(int64_t, m_Program->m_DataStart), false };
 		}
 
 		// get special register index from map
@@ -4,12 +4,12 @@
 
 namespace engine
 {
-	class Script;
+	class ScriptProgram;
 
 	class ScriptParser
 	{
 	public:
-		ScriptParser(const char* fp, Script* const script);
+		ScriptParser(const char* fp, ScriptProgram* const program);
 		ScriptParser(const ScriptParser& other) = delete;
 		ScriptParser(ScriptParser&& other) = delete;
 
@@ -19,7 +19,7 @@ namespace engine
 		constexpr static char s_LabelToken = ':', s_CommentToken = '#', s_StringToken = '"', s_RegToken = '$', s_EntryPointToken[] = "main", s_Whitespace[] = "\t ";
 
 
-		uint m_Line, m_LastStringWrite;
+		uint m_Line;
 		// label definitions
 		std::unordered_map<std::string, uint> m_Labels;
 		// label uses
@@ -27,7 +27,7 @@ namespace engine
 		std::string m_Filepath;
 		std::ifstream m_File;
 		bool m_Abort;
-		Script* m_Script;
+		ScriptProgram* m_Program;
 
 
 		void ParseLine(std::string& line);
@@ -0,0 +1,130 @@
+#include "pch.h"
+#include "ScriptProgram.h"
+#include "ScriptParser.h"
+#include "Script.h"
+
+namespace engine
+{
+	ScriptProgram::ScriptProgram(const char* fp) :
+		m_Compiled(false),
+		m_EntryPoint(0),
+		m_DataStart(s_MemCount),
+		m_Filepath(fp)
+	{
+		// if the source can't be read, the parser will say so
+		std::ifstream in;
+		if constexpr (s_ScriptBytecodeCache)
+			in.open(fp, std::ios::binary);
+		const bool cache = in.is_open();
+		ulong source = 0;
+		if (cache)
+		{
+			const std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+			source = math::fnv1a(text.data(), text.size());
+			// the dump comes from the optimizer, so it has to run every time
+			if (!s_ScriptOptimizerDump && LoadBytecode(m_Filepath + "c", source))
+			{
+				m_Compiled = true;
+				return;
+			}
+		}
+
+		Script::Describe();
+		m_Compiled = ScriptParser(fp, this).Parse();
+		if (cache && m_Compiled)
+			SaveBytecode(m_Filepath + "c", source);
+	}
+
+
+
+	const ScriptProgram* ScriptProgram::Load(const std::string& fp)
+	{
+		const auto& it = s_Programs.find(fp);
+		if (it != s_Programs.end())
+			return it->second;
+		// failures are cached too, so a bad file only prints its errors once
+		ScriptProgram* const program = new ScriptProgram(fp.c_str());
+		s_Programs.emplace(fp, program);
+		return program;
+	}
+
+
+
+	bool ScriptProgram::LoadBytecode(const std::string& fp, ulong source)
+	{
+		// the whole thing in one read
+		std::ifstream in(fp, std::ios::binary | std::ios::ate);
+		if (!in.is_open())
+			return false;
+		const size_t size = CAST(size_t, in.tellg());
+		if (size < sizeof(BytecodeHeader))
+			return false;
+		std::vector<char> bytes(size);
+		in.seekg(0);
+		if (!in.read(bytes.data(), size))
+			return false;
+
+		// anything that doesn't match just means it gets parsed again
+		BytecodeHeader header;
+		memcpy(&header, bytes.data(), sizeof(header));
+		if (memcmp(header.magic, s_BytecodeMagic, sizeof(s_BytecodeMagic)) || header.version != s_BytecodeVersion || header.source != source || header.fingerprint != Script::Fingerprint())
+			return false;
+		if (header.dataStart > s_MemCount || header.entryPoint > header.instructionCount)
+			return false;
+		const size_t code = CAST(size_t, header.instructionCount) * sizeof(Args), data = s_MemCount - header.dataStart;
+		if (size != sizeof(header) + code + data || math::fnv1a(bytes.data() + sizeof(header), code + data) != header.checksum)
+			return false;
+
+		std::vector<Args> instructions(header.instructionCount);
+		memcpy(instructions.data(), bytes.data() + sizeof(header), code);
+		// the checksum only catches accidents, so make sure every handler exists and every register it names does too, since Run trusts both
+		Script::Describe();
+		for (const Args& args : instructions)
+		{
+			if (args.handler >= Script::HandlerCount())
+				return false;
+			const HandlerDescription& desc = Script::s_HandlerDescriptions[args.handler];
+			for (uint i = 0; i < CommandDescription::s_RegCount; i++)
+			{
+				const uint reg = args.reg[i];
+				switch (desc.operands[i])
+				{
+				case Operand::I:	if (reg >= Registers::s_IntRegCount) return false; break;
+				case Operand::F:	if (reg >= Registers::s_FloatRegCount) return false; break;
+				case Operand::V:	if (reg >= Registers::s_VecRegCount) return false; break;
+				default:			break;
+				}
+			}
+		}
+
+		m_EntryPoint = header.entryPoint;
+		m_DataStart = header.dataStart;
+		m_Instructions = std::move(instructions);
+		m_Data.assign(bytes.begin() + sizeof(header) + code, bytes.end());
+		return true;
+	}
+	void ScriptProgram::SaveBytecode(const std::string& fp, ulong source) const
+	{
+		const size_t code = m_Instructions.size() * sizeof(Args);
+		std::vector<char> bytes(code + m_Data.size());
+		memcpy(bytes.data(), m_Instructions.data(), code);
+		memcpy(bytes.data() + code, m_Data.data(), m_Data.size());
+
+		BytecodeHeader header = {};
+		memcpy(header.magic, s_BytecodeMagic, sizeof(s_BytecodeMagic));
+		header.version = s_BytecodeVersion;
+		header.entryPoint = m_EntryPoint;
+		header.dataStart = m_DataStart;
+		header.instructionCount = CAST(uint, m_Instructions.size());
+		header.source = source;
+		header.fingerprint = Script::Fingerprint();
+		header.checksum = math::fnv1a(bytes.data(), bytes.size());
+
+		// not being able to write it (read-only install, etc.) only costs a parse next time
+		std::ofstream out(fp, std::ios::binary | std::ios::trunc);
+		if (!out.is_open())
+			return;
+		out.write(CAST(const char*, CAST(const void*, &header)), sizeof(header));
+		out.write(bytes.data(), bytes.size());
+	}
+}
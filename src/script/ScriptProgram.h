@@ -0,0 +1,78 @@
+#pragma once
+#include "pch.h"
+#include "Command.h"
+
+namespace engine
+{
+	class ScriptParser;
+
+	// A compiled script file. It never changes once it's parsed, so every Script running the same file shares one (see Load), and each Script only holds the state of its own run. If s_ScriptBytecodeCache, it's also saved to disk after it compiles, and later runs load that instead of parsing as long as the source is the same.
+	class ScriptProgram
+	{
+	public:
+		friend class ScriptParser;
+		friend class ScriptOptimizer;
+		// 4KB RAM
+		constexpr static uint s_MemCount = 4096;
+
+
+		ScriptProgram(const char* fp);
+		ScriptProgram(const ScriptProgram& other) = delete;
+		ScriptProgram(ScriptProgram&& other) = delete;
+
+
+		// the ScriptProgram for the file at fp, which is only parsed the first time it's asked for
+		static const ScriptProgram* Load(const std::string& fp);
+		bool IsCompiled() const
+		{
+			return m_Compiled;
+		}
+		const std::vector<Args>& GetInstructions() const
+		{
+			return m_Instructions;
+		}
+		uint GetEntryPoint() const
+		{
+			return m_EntryPoint;
+		}
+		const std::string& GetFilepath() const
+		{
+			return m_Filepath;
+		}
+		// where string literals start in RAM. They run to the end of it, and GetData()[0] is the byte at this address.
+		uint GetDataStart() const
+		{
+			return m_DataStart;
+		}
+		const uchar* GetData() const
+		{
+			return m_Data.data();
+		}
+	private:
+		// bump this whenever the layout of the bytecode file changes
+		constexpr static uint s_BytecodeVersion = 1;
+		constexpr static char s_BytecodeMagic[4] = { 'G', 'S', 'B', 'C' };
+		// followed by the instructions, then the string literals
+		struct BytecodeHeader
+		{
+			char magic[4];
+			uint version, entryPoint, dataStart, instructionCount;
+			// hash of the source file, Script::Fingerprint, and hash of everything after this header
+			ulong source, fingerprint, checksum;
+		};
+		static inline std::unordered_map<std::string, ScriptProgram*> s_Programs;
+
+
+		bool m_Compiled;
+		uint m_EntryPoint, m_DataStart;
+		std::vector<Args> m_Instructions;
+		// string literals, which go at the end of RAM
+		std::vector<uchar> m_Data;
+		std::string m_Filepath;
+
+
+		// true if the bytecode at fp was made from a source file with the given hash by this version of the engine, in which case it's loaded into this
+		bool LoadBytecode(const std::string& fp, ulong source);
+		void SaveBytecode(const std::string& fp, ulong source) const;
+	};
+}
@@ -1,9 +1,11 @@
 #pragma once
 #include "pch.h"
+#include "world/Trigger.h"
 
 namespace engine
 {
 	class Script;
+	class ScriptProgram;
 	class World;
 	struct ScriptRuntime;
 
@@ -16,6 +18,7 @@ namespace engine
 			m_Vel(vel),
 			m_Dim(dim),
 			m_Speed(speed),
+			m_Filter(),
 			m_Scripts(scripts),
 			m_States(math::castMap<std::string, void*>(states)),
 			m_CurrentState(state)
@@ -47,6 +50,10 @@ namespace engine
 		{
 			return m_Speed;
 		}
+		const math::CollisionFilter& GetFilter() const
+		{
+			return m_Filter;
+		}
 		void SetPos(const math::Vec2<float>& pos)
 		{
 			m_Pos = pos;
@@ -58,6 +65,20 @@ namespace engine
 			if (m_Vel.IsZero())
 				m_Vel = { 0.f, 0.f };
 		}
+		// what this collides with, if it has a Hitbox
+		void SetFilter(const math::CollisionFilter& filter)
+		{
+			m_Filter = filter;
+		}
+		// which Triggers in the current Chunk this is in, see Dynamic::UpdateTriggers
+		TriggerTracker& GetTriggers()
+		{
+			return m_Triggers;
+		}
+		const TriggerTracker& GetTriggers() const
+		{
+			return m_Triggers;
+		}
 		void SetState(const std::string& state)
 		{
 			const auto& it = m_States.find(state);
@@ -69,6 +90,8 @@ namespace engine
 	protected:
 		math::Vec2<float> m_Pos, m_Dim, m_Vel;
 		float m_Speed;
+		math::CollisionFilter m_Filter;
+		TriggerTracker m_Triggers;
 		std::unordered_map<std::string, Script*> m_Scripts;
 		std::unordered_map<std::string, int64_t> m_Flags;
 		std::unordered_map<std::string, void*> m_States;
@@ -6,6 +6,9 @@ namespace engine
 {
 	Chunk::Chunk(const ChunkConstructor& constructor) :
 		m_QuadTree(nullptr),
+		m_Statics(nullptr),
+		m_RigidTileCount(0),
+		m_TriggerGrid(nullptr),
 		m_Pos(constructor.pos),
 		m_Dim(0.f, 0.f),
 		m_Lights(nullptr),
@@ -18,6 +21,8 @@ namespace engine
 		std::vector<std::unordered_map<Sprite*, std::vector<Tile>>> groups;
 		// cache indices into `groups` for fast lookup times
 		std::unordered_map<Sprite*, uint> indices;
+		// bounds of every rigid Tile, these become our Hitboxes
+		std::vector<math::MergedRect> rigidRects;
 
 		// for each given Tile
 		for (auto& tile : constructor.tiles)
@@ -29,7 +34,7 @@ namespace engine
 			max.y = math::max(max.y, tile.pos.y + tileDims.y);
 
 			if (tile.rigid)
-				m_Hitboxes.emplace_back(tile.pos, tile.sprite->GetDims(), math::Vec2<float>(0.f, 0.f), nullptr);
+				rigidRects.push_back({ tile.pos, tileDims });
 
 			// get the index of the group that contains our current Tile's sprite
 			Sprite* sprite = tile.sprite;
@@ -92,15 +97,98 @@ namespace engine
 		m_Lights = new gfx::UniformBuffer<GL_STATIC_DRAW>(m_LightCount * sizeof(Light) / sizeof(float), PUN(float*, ptr), 0);
 
 
+		// a solid region only needs a handful of big Hitboxes, not one per Tile
+		m_RigidTileCount = CAST(uint, rigidRects.size());
+		if constexpr (s_MergeRigidTiles)
+		{
+			std::vector<math::MergedRect> merged;
+			math::mergeRects(rigidRects, &merged);
+			rigidRects.swap(merged);
+			if constexpr (s_MergeStats)
+				printf("Merged %llu rigid tiles into %llu Hitboxes\n", CAST(unsigned long long, m_RigidTileCount), CAST(unsigned long long, rigidRects.size()));
+		}
+		m_Hitboxes.reserve(rigidRects.size());
+		for (const math::MergedRect& rect : rigidRects)
+			m_Hitboxes.emplace_back(rect.pos, rect.dim, math::Vec2<float>(0.f, 0.f), nullptr);
+		BuildSolid(constructor.tiles, min, max);
+
+
 		m_QuadTree = new QTNode(min, max);
+		m_QuadTree->SetDeferredMerges(s_DeferredQuadTreeMerges);
+		std::vector<QTNode::Element*> rigid;
+		rigid.reserve(m_Hitboxes.size());
 		for (Hitbox& hb : m_Hitboxes)
-			m_QuadTree->Add(&hb);
+			rigid.push_back(&hb);
+		// tiles never move, so there's no reason to make them share the QuadTree with everything that does
+		if constexpr (s_StaticTileBroadphase)
+		{
+			m_Statics = new QTNode::Statics(rigid.data(), CAST(uint, rigid.size()));
+			m_QuadTree->SetStatics(m_Statics);
+		}
+		else
+			m_QuadTree->Build(rigid.data(), CAST(uint, rigid.size()));
+
+		// triggers are never solid, so they don't go in with the tiles
+		if (!constructor.triggers.empty())
+		{
+			m_Triggers.reserve(constructor.triggers.size());
+			std::vector<QTNode::Element*> triggers;
+			for (const Trigger& trigger : constructor.triggers)
+			{
+				m_Triggers.emplace_back(trigger.pos, trigger.dim, math::Vec2<float>(0.f, 0.f), nullptr);
+				m_Triggers.back().SetTrigger(true);
+				m_TriggerNames.push_back(trigger.name);
+				triggers.push_back(&m_Triggers.back());
+			}
+			m_TriggerGrid = new QTNode::Statics(triggers.data(), CAST(uint, triggers.size()));
+		}
 		m_Dim = max - min;
 		m_Pos = min;
 	}
 
 
 
+	void Chunk::BuildSolid(const std::vector<Tile>& tiles, const math::Vec2<float>& min, const math::Vec2<float>& max)
+	{
+		// find the most common size of rigid Tile, and one of them to line the grid up with
+		std::map<std::pair<float, float>, std::pair<uint, math::Vec2<float>>> sizes;
+		const Tile* anchor = nullptr;
+		uint best = 0;
+		for (const Tile& tile : tiles)
+		{
+			if (!tile.rigid)
+				continue;
+			const math::Vec2<float>& dim = tile.sprite->GetDims();
+			auto& [count, pos] = sizes[{ dim.x, dim.y }];
+			if (count++ == 0)
+				pos = tile.pos;
+			if (count > best)
+			{
+				best = count;
+				anchor = &tile;
+			}
+		}
+
+		// no rigid Tiles, nothing is ever solid
+		if (!anchor)
+		{
+			m_Solid.assign(s_AnyLayer + 1, math::BitGrid());
+			return;
+		}
+
+		const math::Vec2<float> cell = anchor->sprite->GetDims(), first = sizes[{ cell.x, cell.y }].second;
+		const math::Vec2<float> origin(first.x + std::floor((min.x - first.x) / cell.x) * cell.x, first.y + std::floor((min.y - first.y) / cell.y) * cell.y);
+		const uint width = CAST(uint, std::ceil((max.x - origin.x) / cell.x)), height = CAST(uint, std::ceil((max.y - origin.y) / cell.y));
+		m_Solid.assign(s_AnyLayer + 1, math::BitGrid(origin, cell, width, height));
+		for (const Tile& tile : tiles)
+		{
+			if (tile.rigid)
+			{
+				m_Solid[tile.layer].SetRect(tile.pos, tile.sprite->GetDims());
+				m_Solid[s_AnyLayer].SetRect(tile.pos, tile.sprite->GetDims());
+			}
+		}
+	}
 	void Chunk::Draw(Renderer& renderer) const
 	{
 		renderer.SetLights(m_LightCount, *m_Lights);
@@ -2,6 +2,7 @@
 #include "pch.h"
 #include "world/SpriteGroup.h"
 #include "Light.h"
+#include "Trigger.h"
 #include "Hitbox.h"
 
 namespace engine
@@ -13,6 +14,7 @@ namespace engine
 		math::Vec2<float> pos = { 0, 0 };
 		std::vector<Tile> tiles;
 		std::vector<Light> lights;
+		std::vector<Trigger> triggers;
 
 
 		void Merge(ChunkConstructor other, const math::Vec2<float>& offset)
@@ -21,6 +23,7 @@ namespace engine
 
 			CopyVector(other.tiles, tiles, off);
 			CopyVector(other.lights, lights, off);
+			CopyVector(other.triggers, triggers, off);
 		}
 	private:
 		template<typename T>
@@ -36,11 +39,26 @@ namespace engine
 	class Chunk
 	{
 	public:
+		// for IsSolid, checks every layer at once
+		constexpr static uint s_AnyLayer = SpriteGroup::s_LayerCount;
+		// see GetMergeStats
+		struct MergeStats
+		{
+			uint rigidTiles, hitboxes;
+		};
+
+
 		Chunk(const ChunkConstructor& constructor);
 		Chunk(const Chunk& other) = delete;
 		Chunk(Chunk&& other) noexcept :
 			m_QuadTree(other.m_QuadTree),
+			m_Statics(other.m_Statics),
 			m_Hitboxes(std::move(other.m_Hitboxes)),
+			m_RigidTileCount(other.m_RigidTileCount),
+			m_Solid(std::move(other.m_Solid)),
+			m_Triggers(std::move(other.m_Triggers)),
+			m_TriggerNames(std::move(other.m_TriggerNames)),
+			m_TriggerGrid(other.m_TriggerGrid),
 			m_Pos(other.m_Pos),
 			m_Dim(other.m_Dim),
 			m_SpriteGroups(std::move(other.m_SpriteGroups)),
@@ -48,10 +66,15 @@ namespace engine
 			m_LightCount(other.m_LightCount)
 		{
 			other.m_QuadTree = nullptr;
+			other.m_Statics = nullptr;
+			other.m_TriggerGrid = nullptr;
 			other.m_Lights = nullptr;
 		}
 		~Chunk()
 		{
+			delete m_QuadTree;
+			delete m_Statics;
+			delete m_TriggerGrid;
 			delete m_Lights;
 		}
 
@@ -69,12 +92,58 @@ namespace engine
 		{
 			return m_Dim;
 		}
+		// how many rigid Tiles this Chunk has, and how many Hitboxes they became (the same number unless s_MergeRigidTiles)
+		MergeStats GetMergeStats() const
+		{
+			return { m_RigidTileCount, CAST(uint, m_Hitboxes.size()) };
+		}
+		// Whether the tile cell containing pos holds a rigid Tile on the given layer (or any layer). Much cheaper than asking the QuadTree, but only exact for Tiles lined up with the cells, see m_Solid.
+		bool IsSolid(const math::Vec2<float>& pos, uint layer = s_AnyLayer) const
+		{
+			return m_Solid[layer].TestPoint(pos);
+		}
+		// same, for any cell the given rect overlaps
+		bool IsSolid(const math::Vec2<float>& pos, const math::Vec2<float>& dim, uint layer = s_AnyLayer) const
+		{
+			return m_Solid[layer].TestRect(pos, dim);
+		}
+		// Calls fn(index) for each Trigger whose area overlaps what the given rect covers while moving by `motion`, and that accepts filter
+		template<typename FN>
+		void QueryTriggers(const math::Vec2<float>& pos, const math::Vec2<float>& dim, const math::Vec2<float>& motion, const math::CollisionFilter& filter, const FN& fn) const
+		{
+			if (m_TriggerGrid)
+				m_TriggerGrid->QuerySwept(pos, dim, motion, filter, [&](QTNode::Element* const e) { fn(CAST(uint, CAST(const Hitbox*, e) - m_Triggers.data())); });
+		}
+		// index of the Trigger with the given name, or -1
+		int FindTrigger(const std::string& name) const
+		{
+			for (uint i = 0; i < m_TriggerNames.size(); i++)
+				if (m_TriggerNames[i] == name)
+					return CAST(int, i);
+			return -1;
+		}
+		bool HasTriggers() const
+		{
+			return !m_Triggers.empty();
+		}
 	private:
 		QTNode* m_QuadTree;
+		// rigid tiles, if s_StaticTileBroadphase is set. Points into m_Hitboxes.
+		QTNode::Statics* m_Statics;
 		std::vector<Hitbox> m_Hitboxes;
+		uint m_RigidTileCount;
+		// Which cells of a grid over the Chunk hold a rigid Tile, for each layer and then for all of them (s_AnyLayer). Cells are the size of the most common rigid Tile and lined up with one of them, and a cell counts as solid if its center is inside a rigid Tile.
+		std::vector<math::BitGrid> m_Solid;
+		// one Hitbox per Trigger, in their own grid so that they never get resolved against. Indices match m_TriggerNames.
+		std::vector<Hitbox> m_Triggers;
+		std::vector<std::string> m_TriggerNames;
+		QTNode::Statics* m_TriggerGrid;
 		math::Vec2<float> m_Pos, m_Dim;
 		std::vector<SpriteGroup> m_SpriteGroups;
 		gfx::UniformBuffer<GL_STATIC_DRAW>* m_Lights;
 		uint m_LightCount;
+
+
+		void BuildSolid(const std::vector<Tile>& tiles, const math::Vec2<float>& min, const math::Vec2<float>& max);
 	};
 }
@@ -0,0 +1,176 @@
+#include "pch.h"
+#include "Hitbox.h"
+
+namespace engine
+{
+	// A Hitbox on NODE_OF's broadphase (see QTNodeOf), with static dispatch if STATIC, so that Benchmark can time configurations that Core.h didn't pick next to the one it did
+	template<template<typename> typename NODE_OF, bool STATIC>
+	class BenchmarkHitbox;
+	template<template<typename> typename NODE_OF, bool STATIC>
+	using BenchmarkNode = NODE_OF<std::conditional_t<STATIC, BenchmarkHitbox<NODE_OF, STATIC>, void>>;
+	template<template<typename> typename NODE_OF, bool STATIC>
+	class BenchmarkHitbox final : public HitboxBase<typename BenchmarkNode<NODE_OF, STATIC>::Element>
+	{
+	public:
+		using HitboxBase<typename BenchmarkNode<NODE_OF, STATIC>::Element>::HitboxBase;
+	};
+
+
+
+	// every broadphase, for BenchmarkHitbox's NODE_OF
+	template<typename DERIVED>
+	using StrictQuadTreeOf = math::QuadTreeNode<s_QuadTreeThreshold, math::QuadTreeStrict, DERIVED>;
+	template<typename DERIVED>
+	using LooseQuadTreeOf = math::QuadTreeNode<s_QuadTreeThreshold, math::QuadTreeLoose, DERIVED>;
+	template<typename DERIVED>
+	using LinearQuadTreeOf = math::LinearQuadTree<s_QuadTreeThreshold, DERIVED>;
+	template<typename DERIVED>
+	using SpatialHashOf = math::SpatialHash<s_SpatialHashCellDim, DERIVED>;
+
+
+
+	// see Hitbox::Benchmark
+	template<template<typename> typename NODE_OF, bool STATIC>
+	static void BenchmarkCollisions(const char* broadphase, uint count, float seconds)
+	{
+		typedef BenchmarkNode<NODE_OF, STATIC> Node;
+		typedef typename Node::Element Element;
+		typedef BenchmarkHitbox<NODE_OF, STATIC> Box;
+		const char* const dispatch = STATIC ? "static" : "virtual";
+		constexpr float side = 2048.f, tile = 16.f, delta = 1.f / 60.f, speed = 100.f;
+		const math::Vec2<float> dim = { 8.f, 8.f };
+
+		// same numbers every time, and without touching std::rand
+		uint seed = 1;
+		const auto random = [&seed](float min, float max)
+		{
+			seed ^= seed << 13;
+			seed ^= seed >> 17;
+			seed ^= seed << 5;
+			return min + (max - min) * (seed & 0xffffff) / CAST(float, 0x1000000);
+		};
+
+		// a solid border, with about one tile in 16 filled in inside it
+		const uint tiles = CAST(uint, side / tile);
+		std::vector<Box> walls;
+		walls.reserve(tiles * tiles);
+		for (uint y = 0; y < tiles; y++)
+			for (uint x = 0; x < tiles; x++)
+				if (x == 0 || y == 0 || x == tiles - 1 || y == tiles - 1 || random(0.f, 1.f) < 1.f / 16.f)
+					walls.emplace_back(math::Vec2<float>(x * tile, y * tile), math::Vec2<float>(tile, tile), math::Vec2<float>(0.f, 0.f));
+		std::vector<Element*> statics;
+		statics.reserve(walls.size());
+		for (Box& box : walls)
+			statics.push_back(&box);
+		const typename Node::Statics grid(statics.data(), CAST(uint, statics.size()));
+
+		typedef std::chrono::steady_clock clock;
+		for (const bool clustered : { false, true })
+		{
+			Node* const root = new Node({ 0.f, 0.f }, { side, side });
+			root->SetDeferredMerges(s_DeferredQuadTreeMerges);
+			root->SetStatics(&grid);
+			// every part gets its own seed, since how many frames fit in the time changes how many numbers the one before it used
+			seed = clustered ? 3 : 2;
+
+			// everything packed into 8 clumps 16 Hitboxes wide (without overlapping to start with), or anywhere inside the border
+			math::Vec2<float> centers[8];
+			for (math::Vec2<float>& center : centers)
+				center = { random(side / 8.f, side * 7.f / 8.f), random(side / 8.f, side * 7.f / 8.f) };
+			std::vector<Box*> boxes(count);
+			std::vector<math::Vec2<float>> pos(count), vel(count);
+			for (uint i = 0; i < count; i++)
+			{
+				if (clustered)
+					pos[i] = centers[i % 8] + math::Vec2<float>((i / 8 % 16) * 12.f, (i / 8 / 16) * 12.f);
+				else
+					pos[i] = { random(2.f * tile, side - 2.f * tile), random(2.f * tile, side - 2.f * tile) };
+				vel[i] = { random(-speed, speed), random(-speed, speed) };
+				boxes[i] = new Box(pos[i], dim, vel[i]);
+				root->Add(boxes[i]);
+			}
+
+			// same steps as a frame of DynamicList::Update, without the sweep
+			const auto start = clock::now();
+			uint frames = 0;
+			double elapsed = 0.;
+			do
+			{
+				for (uint i = 0; i < count; i++)
+				{
+					// things that got stopped by a wall get a new direction every so often, so that the crowd keeps moving
+					if ((frames + i) % 60 == 0)
+						vel[i] = { random(-speed, speed), random(-speed, speed) };
+					pos[i] += vel[i] * delta;
+					boxes[i]->Move(pos[i], dim, vel[i], root);
+				}
+				for (uint i = 0; i < count; i++)
+				{
+					boxes[i]->Update(delta);
+					pos[i] = boxes[i]->GetPos();
+					vel[i] = boxes[i]->GetVel();
+				}
+				root->EndFrame();
+				frames++;
+				elapsed = std::chrono::duration<double>(clock::now() - start).count();
+			} while (elapsed < seconds);
+			printf("[%s, %s dispatch]: %u Hitboxes %s, %f ms per frame (%u frames)\n", broadphase, dispatch, count, clustered ? "clustered" : "spread out", elapsed * 1000. / frames, frames);
+
+			delete root;
+			for (Box* box : boxes)
+				delete box;
+		}
+
+		// The candidate tests on their own. Detect is the narrowphase, run on rows of Hitboxes a couple of pixels apart (give or take) so that some of them hit. Build calls IsContainedBy for every Node each Hitbox reaches.
+		seed = 4;
+		std::vector<Box> boxes;
+		boxes.reserve(count);
+		for (uint i = 0; i < count; i++)
+			boxes.emplace_back(math::Vec2<float>((i % 32) * 10.f + random(-2.f, 2.f), (i / 32) * 10.f + random(-2.f, 2.f)), dim, math::Vec2<float>(random(-speed, speed), random(-speed, speed)));
+		std::vector<Element*> elements;
+		elements.reserve(count);
+		for (Box& box : boxes)
+			elements.push_back(&box);
+
+		typename Box::CollisionInfo info = {};
+		ulong tests = 0, hits = 0;
+		const auto detectStart = clock::now();
+		double detectElapsed = 0.;
+		do
+		{
+			for (uint i = 0; i < count; i++)
+				for (uint j = 1; j <= 16; j++)
+					hits += elements[i]->Detect(elements[(i + j) % count], delta, &info);
+			tests += 16 * count;
+			detectElapsed = std::chrono::duration<double>(clock::now() - detectStart).count();
+		} while (detectElapsed < seconds / 2.f);
+
+		for (Box& box : boxes)
+			box.SetPos({ random(2.f * tile, side - 2.f * tile), random(2.f * tile, side - 2.f * tile) });
+		uint builds = 0;
+		const auto buildStart = clock::now();
+		double buildElapsed = 0.;
+		do
+		{
+			Node* const root = new Node({ 0.f, 0.f }, { side, side });
+			root->Build(elements.data(), count);
+			delete root;
+			builds++;
+			buildElapsed = std::chrono::duration<double>(clock::now() - buildStart).count();
+		} while (buildElapsed < seconds / 2.f);
+		printf("[%s, %s dispatch]: %f ns per Detect (%llu hits out of %u), %f us per Build of %u Hitboxes\n", broadphase, dispatch, detectElapsed * 1e9 / tests, CAST(unsigned long long, hits / (tests / (16 * count))), 16 * count, buildElapsed * 1e6 / builds, count);
+	}
+
+
+
+	void Hitbox::Benchmark(uint count, float seconds)
+	{
+		const char* const broadphase = s_Broadphase == Broadphase::SPATIAL_HASH ? "SpatialHash" : (s_Broadphase == Broadphase::LINEAR_QUAD_TREE ? "LinearQuadTree" : (QTPolicy::s_Loose ? "loose QuadTree" : "strict QuadTree"));
+		// every broadphase with the dispatch in use, then the other dispatch on the broadphase in use, since flipping either toggle means rebuilding
+		BenchmarkCollisions<StrictQuadTreeOf, s_StaticElementDispatch>("strict QuadTree", count, seconds);
+		BenchmarkCollisions<LooseQuadTreeOf, s_StaticElementDispatch>("loose QuadTree", count, seconds);
+		BenchmarkCollisions<LinearQuadTreeOf, s_StaticElementDispatch>("LinearQuadTree", count, seconds);
+		BenchmarkCollisions<SpatialHashOf, s_StaticElementDispatch>("SpatialHash", count, seconds);
+		BenchmarkCollisions<QTNodeOf, !s_StaticElementDispatch>(broadphase, count, seconds);
+	}
+}
@@ -3,23 +3,58 @@
 
 namespace engine
 {
-	class Hitbox : public math::QuadTreeElement<s_QuadTreeThreshold>
+	// Everything a Hitbox does, on top of any broadphase's Element. ELEMENT's DERIVED has to be the class that derives from this, or void. The engine only uses Hitbox, on QTNode, Hitbox::Benchmark makes others to compare against it.
+	template<typename ELEMENT>
+	class HitboxBase : public ELEMENT
 	{
+		// for s_StaticElementDispatch
+		friend ELEMENT;
+		friend typename ELEMENT::Collider;
+	protected:
+		typedef typename ELEMENT::Node Node;
 	public:
-		Hitbox(const math::Vec2<float>& pos, const math::Vec2<float>& dim, const math::Vec2<float>& vel, Node* const root) :
-			Element(pos, dim, vel)
-		{
-			if (root)
-				root->Add(this);
-		}
-		Hitbox(const Hitbox& other) = delete;
-		Hitbox(Hitbox&& other) noexcept :
-			Element(std::move(other))
+		typedef typename ELEMENT::CollisionInfo CollisionInfo;
+
+
+		// not added to a Node yet, since with s_StaticElementDispatch that would call into the derived class before it's constructed
+		HitboxBase(const math::Vec2<float>& pos, const math::Vec2<float>& dim, const math::Vec2<float>& vel) :
+			ELEMENT(pos, dim, vel),
+			m_Trigger(false)
+		{}
+		HitboxBase(const HitboxBase& other) = delete;
+		HitboxBase(HitboxBase&& other) noexcept :
+			ELEMENT(std::move(other)),
+			m_Trigger(other.m_Trigger)
 		{}
 
 
 		void ResolveCollision(const CollisionInfo& info) override
 		{
+			// triggers are still found like anything else (so they show up in DynamicList::GetCollisionEvents), but nothing is ever pushed out of one
+			if (m_Trigger || CAST(const HitboxBase*, info.element)->m_Trigger)
+				return;
+
+			// we ran into info.element partway through this step (see Intersects). Back up to where that happened, stop moving into it, and slide along it for the rest of the step.
+			if (info.normal != 0.f)
+			{
+				const math::Vec2<float> remaining = m_Pos - info.contact, & ov = info.element->GetVel();
+				m_Pos = info.contact;
+				if (info.normal.x != 0.f)
+				{
+					m_Pos.y += remaining.y;
+					info.element->SetVel({ 0.f, ov.y });
+					m_Vel.x = 0.f;
+				}
+				else
+				{
+					m_Pos.x += remaining.x;
+					info.element->SetVel({ ov.x, 0.f });
+					m_Vel.y = 0.f;
+				}
+				return;
+			}
+
+			// otherwise we were already overlapping, so push out whichever way is shortest
 			const auto& op = info.element->GetPos(), od = info.element->GetDim();
 			const float distances[4] =
 			{
@@ -75,8 +110,21 @@ namespace engine
 				}
 			}
 		}
+		bool IsTrigger() const
+		{
+			return m_Trigger;
+		}
+		void SetTrigger(bool trigger)
+		{
+			m_Trigger = trigger;
+		}
 	private:
+		using ELEMENT::m_Pos;
+		using ELEMENT::m_Dim;
+		using ELEMENT::m_Vel;
 		constexpr static math::RangeOverlapsParams s_OverlapsParams = { .left = { true, true }, .right = { true, true } };
+		// if true, this only reports overlaps and never resolves them
+		bool m_Trigger;
 
 
 
@@ -84,9 +132,44 @@ namespace engine
 		{
 			return math::rectIntersect(node->GetPos(), math::Vec2<float>(1.f * node->GetDim(), 1.f * node->GetDim()), m_Pos, m_Dim, s_OverlapsParams);
 		}
-		bool Intersects(const QuadTreeElement* const other, float delta, math::Vec2<float>* const normal, math::Vec2<float>* const contact, float* const time) const override
+		// Swept test over the last step, so that fast Hitboxes can't pass through things between frames. Each Hitbox is assumed to have moved in a straight line from GetPos() - GetVel() * delta, so relative to other we trace our center along (m_Vel - other's vel) * delta against other grown by our size. On a hit, time is the fraction of the step at which it happened, normal is the face we hit, and contact is where we were (top left) at that time.
+		// Things that were already overlapping when the step began aren't hit by the sweep, so they fall back to a plain overlap test and report a time of 0 and a normal of 0.
+		bool Intersects(const ELEMENT* const other, float delta, math::Vec2<float>* const normal, math::Vec2<float>* const contact, float* const time) const override
 		{
-			return math::rectIntersect(m_Pos, m_Dim, other->GetPos(), other->GetDim(), s_OverlapsParams);
+			const math::Vec2<float> start = m_Pos - m_Vel * delta, motion = (m_Vel - other->GetVel()) * delta;
+			if (motion != 0.f)
+			{
+				math::Ray<float> ray(start + m_Dim / 2.f, motion);
+				float t = 0.f;
+				if (ray.IntersectsRect(other->GetPos() - other->GetVel() * delta - m_Dim / 2.f, other->GetDim() + m_Dim, normal, nullptr, &t))
+				{
+					*contact = start + m_Vel * (delta * t);
+					*time = t;
+					return true;
+				}
+			}
+
+			if (!math::rectIntersect(m_Pos, m_Dim, other->GetPos(), other->GetDim(), s_OverlapsParams))
+				return false;
+			*normal = { 0.f, 0.f };
+			*contact = m_Pos;
+			*time = 0.f;
+			return true;
 		}
 	};
+
+	class Hitbox final : public HitboxBase<QTNode::Element>
+	{
+	public:
+		Hitbox(const math::Vec2<float>& pos, const math::Vec2<float>& dim, const math::Vec2<float>& vel, Node* const root) :
+			HitboxBase(pos, dim, vel)
+		{
+			if (root)
+				root->Add(this);
+		}
+
+
+		// Moves `count` Hitboxes around a walled-in area full of tiles for about the given number of seconds, once spread out evenly and once bunched up into a few clusters, and prints the time per frame for each. Then prints what Detect and Build cost on their own. Each configuration sees the same crowd. This runs on every broadphase with the dispatch that s_StaticElementDispatch picks, then with the other dispatch on the broadphase that s_Broadphase picks.
+		static void Benchmark(uint count, float seconds);
+	};
 }
@@ -145,6 +145,15 @@ namespace engine
 
 		constructor.lights.push_back(light);
 	}
+	void Map::AddTrigger(std::ifstream& in, SpriteBank& bank, ChunkConstructor& constructor)
+	{
+		Trigger trigger;
+
+		in >> trigger.name >> trigger.pos.x >> trigger.pos.y >> trigger.dim.x >> trigger.dim.y;
+		trigger.pos += constructor.pos;
+
+		constructor.triggers.push_back(trigger);
+	}
 	void Map::UpdateSettings(std::ifstream& in, TopLevelParams& params)
 	{
 		std::string word;
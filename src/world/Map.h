@@ -20,6 +20,10 @@ namespace engine
 		{
 			return m_Chunks[m_CurrentChunk].GetQuadTree();
 		}
+		const Chunk& GetCurrentChunk() const
+		{
+			return m_Chunks[m_CurrentChunk];
+		}
 	private:
 		struct TopLevelParams
 		{
@@ -41,6 +45,7 @@ namespace engine
 		void AddRect(std::ifstream& in, SpriteBank& bank, ChunkConstructor& constructor);
 		void AddPattern(std::ifstream& in, SpriteBank& bank, ChunkConstructor& constructor);
 		void AddLight(std::ifstream& in, SpriteBank& bank, ChunkConstructor& constructor);
+		void AddTrigger(std::ifstream& in, SpriteBank& bank, ChunkConstructor& constructor);
 		// SETTING
 		void UpdateSettings(std::ifstream& in, TopLevelParams& params);
 		void SetClearColor(std::ifstream& in, EngineInstance& engine);
@@ -104,7 +109,8 @@ namespace engine
 			{ "tile", &Map::AddTile },
 			{ "rect", &Map::AddRect },
 			{ "pattern", &Map::AddPattern },
-			{ "light", &Map::AddLight }
+			{ "light", &Map::AddLight },
+			{ "trigger", &Map::AddTrigger }
 		};
 		// stuff that can go in a SETTING block
 		typedef void(Map::* SettingFunc)(std::ifstream&, EngineInstance&);
@@ -0,0 +1,104 @@
+#pragma once
+#include "pch.h"
+
+namespace engine
+{
+	class Chunk;
+
+	// Non-solid area from a TRIGGER line in the map. Things pass right through it, but each Dynamic is told when it enters, stays in, and exits it (see TriggerTracker).
+	struct Trigger
+	{
+		std::string name;
+		math::Vec2<float> pos = { 0.f, 0.f }, dim = { 0.f, 0.f };
+	};
+
+	// values match what the trigger script ops return, 0 means outside
+	enum class TriggerEventType
+	{
+		ENTER = 1, STAY, EXIT
+	};
+
+	// Which of the current Chunk's Triggers one object is in, and how that changed in the last Update
+	class TriggerTracker
+	{
+	public:
+		struct Event
+		{
+			// Chunk whose Triggers this is about. After changing Chunks, the EXITs are for the old one.
+			const Chunk* chunk;
+			// index into chunk's Triggers
+			uint trigger;
+			TriggerEventType type;
+		};
+
+
+		TriggerTracker() :
+			m_Chunk(nullptr),
+			m_Next(0)
+		{}
+
+
+		// overlapping is every Trigger of chunk that we overlap now, sorted. Compared to last time, that gives an ENTER, STAY, or EXIT for each Trigger we're in or just left. Changing Chunks exits everything in the old one.
+		void Update(const Chunk* const chunk, const std::vector<uint>& overlapping)
+		{
+			m_Events.clear();
+			m_Next = 0;
+			if (chunk != m_Chunk)
+			{
+				for (const uint trigger : m_Inside)
+					m_Events.push_back({ m_Chunk, trigger, TriggerEventType::EXIT });
+				m_Inside.clear();
+				m_Chunk = chunk;
+			}
+
+			// both lists are sorted, so walk them together
+			uint old = 0;
+			for (const uint trigger : overlapping)
+			{
+				for (; old < m_Inside.size() && m_Inside[old] < trigger; old++)
+					m_Events.push_back({ chunk, m_Inside[old], TriggerEventType::EXIT });
+				const bool stayed = old < m_Inside.size() && m_Inside[old] == trigger;
+				m_Events.push_back({ chunk, trigger, stayed ? TriggerEventType::STAY : TriggerEventType::ENTER });
+				old += stayed;
+			}
+			for (; old < m_Inside.size(); old++)
+				m_Events.push_back({ chunk, m_Inside[old], TriggerEventType::EXIT });
+			m_Inside = overlapping;
+		}
+		// nothing to exit and nothing left to report, so Update can be skipped while there are no Triggers around
+		bool IsIdle() const
+		{
+			return m_Inside.empty() && m_Events.empty();
+		}
+		const std::vector<Event>& GetEvents() const
+		{
+			return m_Events;
+		}
+		// what happened with the given Trigger of the current Chunk in the last Update, 0 if we weren't in it at all
+		uint GetState(uint trigger) const
+		{
+			for (const Event& event : m_Events)
+				if (event.chunk == m_Chunk && event.trigger == trigger)
+					return CAST(uint, event.type);
+			return 0;
+		}
+		// The events from the last Update one at a time, for scripts. Returns false once they've all been read. Scripts can only make sense of Triggers in the current Chunk, so EXITs from the last one are skipped.
+		bool Next(Event* const event)
+		{
+			for (; m_Next < m_Events.size(); m_Next++)
+				if (m_Events[m_Next].chunk == m_Chunk)
+				{
+					*event = m_Events[m_Next++];
+					return true;
+				}
+			return false;
+		}
+	private:
+		// Chunk that m_Inside refers to
+		const Chunk* m_Chunk;
+		// sorted
+		std::vector<uint> m_Inside;
+		std::vector<Event> m_Events;
+		uint m_Next;
+	};
+}
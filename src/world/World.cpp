@@ -33,7 +33,7 @@ namespace engine
 	void World::Draw(Renderer& renderer, Camera& cam, const Dynamic* const player)
 	{
 		ScriptRuntime rt = { &renderer, this };
-		m_DynamicList->Update(m_Map->GetCurrentQuadTree(), rt);
+		m_DynamicList->Update(m_Map->GetCurrentQuadTree(), m_Map->GetCurrentChunk(), rt);
 
 		cam.RunScripts(rt);
 		renderer.SetCamera(cam);
@@ -49,9 +49,13 @@ namespace engine
 	{
 		return new Dynamic({}, m_Map->GetCurrentQuadTree(), *m_DynamicList, pos, vel, speed, states, state);
 	}
-	void World::CreateDynamicTemplate(const std::string& name, const std::unordered_map<std::string, Script*>& scripts, const std::unordered_map<std::string, Sprite*>& states, const std::string& state, float speed)
+	void World::CreateDynamicTemplate(const std::string& name, const std::unordered_map<std::string, std::string>& scripts, const std::unordered_map<std::string, Sprite*>& states, const std::string& state, float speed, const math::CollisionFilter& filter, bool trigger)
 	{
-		m_DynamicBank->Put(name, scripts, states, state, speed);
+		// each file is only parsed once, no matter how many templates or Dynamics use it
+		std::unordered_map<std::string, const ScriptProgram*> programs;
+		for (const auto& [script, fp] : scripts)
+			programs.emplace(script, ScriptProgram::Load(fp));
+		m_DynamicBank->Put(name, programs, states, state, speed, filter, trigger);
 	}
 	Dynamic* World::CreateDynamic(const std::string& name, bool add)
 	{
@@ -64,4 +68,16 @@ namespace engine
 	{
 		return new Character(fp, m_Map->GetCurrentQuadTree(), *m_DynamicList, pos, vel, speed, states, state);
 	}
+	bool World::IsSolid(const math::Vec2<float>& pos) const
+	{
+		return m_Map->GetCurrentChunk().IsSolid(pos);
+	}
+	bool World::IsSolid(const math::Vec2<float>& pos, const math::Vec2<float>& dim) const
+	{
+		return m_Map->GetCurrentChunk().IsSolid(pos, dim);
+	}
+	int World::FindTrigger(const std::string& name) const
+	{
+		return m_Map->GetCurrentChunk().FindTrigger(name);
+	}
 }
@@ -30,9 +30,14 @@ namespace engine
 		void Draw(Renderer& renderer, Camera& cam, const Dynamic* const player);
 		Sprite* PutSprite(const char* fp, uint frames, uint time);
 		Dynamic* CreateDynamic(const math::Vec2<float>& pos, const math::Vec2<float>& vel, float speed, const std::unordered_map<std::string, Sprite*>& states, const std::string& state);
-		void CreateDynamicTemplate(const std::string& name, const std::unordered_map<std::string, Script*>& scripts, const std::unordered_map<std::string, Sprite*>& states, const std::string& state, float speed);
+		void CreateDynamicTemplate(const std::string& name, const std::unordered_map<std::string, std::string>& scripts, const std::unordered_map<std::string, Sprite*>& states, const std::string& state, float speed, const math::CollisionFilter& filter = {}, bool trigger = false);
 		Dynamic* CreateDynamic(const std::string& name, bool add);
 		Character* const CreateCharacter(const char* fp, const math::Vec2<float>& pos, const math::Vec2<float>& vel, float speed, const std::unordered_map<std::string, Sprite*>& states, const std::string& state);
+		// whether there's a rigid tile at pos (or anywhere in the rect at pos with the given dimensions) in the current Chunk, see Chunk::IsSolid
+		bool IsSolid(const math::Vec2<float>& pos) const;
+		bool IsSolid(const math::Vec2<float>& pos, const math::Vec2<float>& dim) const;
+		// index of the current Chunk's Trigger with the given name, or -1
+		int FindTrigger(const std::string& name) const;
 	private:
 		SpriteBank* m_SpriteBank;
 		Map* m_Map;
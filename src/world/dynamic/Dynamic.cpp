@@ -1,27 +1,43 @@
 #include "pch.h"
 #include "Dynamic.h"
+#include "world/Chunk.h"
 #include "graphics/Renderer.h"
 #include "graphics/Sprite.h"
+#include "script/Script.h"
 
 namespace engine
 {
+	// a new Script for each of a DynamicTemplate's programs, so that Dynamics made from the same one don't share any state
+	static std::unordered_map<std::string, Script*> instantiate(const std::unordered_map<std::string, const ScriptProgram*>& programs)
+	{
+		std::unordered_map<std::string, Script*> scripts;
+		for (const auto& [name, program] : programs)
+			scripts.emplace(name, new Script(program));
+		return scripts;
+	}
+
+
+
 	Dynamic::Dynamic(QTNode* const root, DynamicList& dl, const DynamicTemplate& temp, bool add) :
-		Scriptable({ 0.f, 0.f }, { 0.f, 0.f }, { 0.f, 0.f }, temp.speed, temp.scripts, temp.states, temp.state),
+		Scriptable({ 0.f, 0.f }, { 0.f, 0.f }, { 0.f, 0.f }, temp.speed, instantiate(temp.scripts), temp.states, temp.state),
 		m_Vertices{ 0.f },
 		m_Handle((add ? dl.Add(this) : DynamicList::Handle(0, 0, 0))),
 		m_Hitbox(nullptr),
-		m_Added(add)
+		m_Added(add),
+		m_Trigger(temp.trigger)
 	{
-		Init(root);
+		m_Filter = temp.filter;
+		Init(root, dl);
 	}
 	Dynamic::Dynamic(const std::unordered_map<std::string, Script*>& scripts, QTNode* const root, DynamicList& list, const math::Vec2<float>& pos, const math::Vec2<float>& vel, float speed, const std::unordered_map<std::string, Sprite*>& states, const std::string& state) :
 		Scriptable(pos, vel, { 0.f, 0.f }, speed, scripts, states, state),
 		m_Vertices{ 0.f },
 		m_Handle(list.Add(this)),
 		m_Hitbox(nullptr),
-		m_Added(true)
+		m_Added(true),
+		m_Trigger(false)
 	{
-		Init(root);
+		Init(root, list);
 	}
 
 
@@ -36,11 +52,32 @@ namespace engine
 	void Dynamic::MoveHitbox(QTNode* const root)
 	{
 		// update hitbox with current values
+		m_Hitbox->SetFilter(m_Filter);
 		m_Hitbox->Move(m_Pos - m_Dim / 2.f, m_Dim, m_Vel, root);
 	}
+	void Dynamic::FindCollisions(float delta, DynamicList& list, uint thread) const
+	{
+		uint count = 0;
+		const auto* const contacts = list.m_Pairs.GetContacts(m_Handle.list, &count);
+		auto& collisions = list.m_Collisions[thread];
+		const uint start = CAST(uint, collisions.size());
+		list.m_CollisionRanges[m_Handle.list] = { thread, start, m_Hitbox->FindCollisions(delta, contacts, count, &collisions), m_Hitbox->GetVel() };
+	}
 	void Dynamic::ResolveCollisions(float delta, DynamicList& list)
 	{
-		m_Hitbox->Update(delta);
+		// Everything was already found by FindCollisions. If something resolved before us stopped us along one axis, our sweep doesn't cover the same area anymore, so look again like the serial path would have.
+		const DynamicList::CollisionRange* const range = DynamicList::s_ParallelCollisions ? &list.m_CollisionRanges[m_Handle.list] : nullptr;
+		if (range && range->vel == m_Hitbox->GetVel())
+			m_Hitbox->ResolveCollisions(delta, list.m_Collisions[range->thread].data() + range->start, range->count);
+		// DynamicList already found every other Dynamic we're touching
+		else if constexpr (s_DynamicSweep)
+		{
+			uint count = 0;
+			const auto* const contacts = list.m_Pairs.GetContacts(m_Handle.list, &count);
+			m_Hitbox->Update(delta, contacts, count);
+		}
+		else
+			m_Hitbox->Update(delta);
 
 		// copy "resolved" values from the hitbox
 		SetVel(m_Hitbox->GetVel());
@@ -48,6 +85,16 @@ namespace engine
 		UpdateVertices();
 		list.Update(m_Handle.list);
 	}
+	void Dynamic::UpdateTriggers(const Chunk& chunk, float delta, std::vector<uint>& scratch)
+	{
+		// everything we went through during the step counts, so fast objects can't skip over a Trigger
+		const math::Vec2<float> motion = m_Hitbox->GetVel() * delta;
+		scratch.clear();
+		chunk.QueryTriggers(m_Hitbox->GetPos() - motion, m_Hitbox->GetDim(), motion, m_Filter, [&scratch](uint trigger) { scratch.push_back(trigger); });
+		std::sort(scratch.begin(), scratch.end());
+		scratch.erase(std::unique(scratch.begin(), scratch.end()), scratch.end());
+		m_Triggers.Update(&chunk, scratch);
+	}
 	void Dynamic::Update(float delta)
 	{
 		m_Pos += m_Vel * delta;
@@ -76,13 +123,17 @@ namespace engine
 			m_Vertices[off + 5] = m_Pos.y;
 		}
 	}
-	void Dynamic::Init(QTNode* const root)
+	void Dynamic::Init(QTNode* const root, DynamicList& dl)
 	{
 		SetState(m_CurrentState);
 		m_Dim = GetCurrentSprite()->GetDims();
 		UpdateVertices();
 
-		if(m_Added)
+		if (m_Added)
+		{
 			m_Hitbox = new Hitbox(m_Pos - m_Dim / 2.f, m_Dim, m_Vel, root);
+			m_Hitbox->SetTrigger(m_Trigger);
+			dl.m_Sweep.Add(m_Hitbox, m_Handle.list);
+		}
 	}
 }
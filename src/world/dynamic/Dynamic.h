@@ -8,13 +8,18 @@ namespace engine
 {
 	class Sprite;
 	class Renderer;
+	class Chunk;
 
 	struct DynamicTemplate
 	{
-		std::unordered_map<std::string, Script*> scripts;
+		// every Dynamic made from this gets its own Script for each of these
+		std::unordered_map<std::string, const ScriptProgram*> scripts;
 		std::unordered_map<std::string, Sprite*> states;
 		std::string state;
 		float speed;
+		math::CollisionFilter filter;
+		// if true, this only reports overlaps and never gets pushed out of anything (see Hitbox::SetTrigger)
+		bool trigger;
 	};
 
 	class Dynamic : public Scriptable
@@ -35,7 +40,11 @@ namespace engine
 
 		const std::unordered_map<std::string, int64_t>& RunScripts(ScriptRuntime& rt) override;
 		void MoveHitbox(QTNode* const root);
+		// (s_ParallelCollisions only) finds everything ResolveCollisions will need to resolve, and stores it in the given thread's part of list. Safe to call for different Dynamics at the same time.
+		void FindCollisions(float delta, DynamicList& list, uint thread) const;
 		void ResolveCollisions(float delta, DynamicList& list);
+		// finds which of chunk's Triggers we passed through this step, see TriggerTracker. Call after ResolveCollisions.
+		void UpdateTriggers(const Chunk& chunk, float delta, std::vector<uint>& scratch);
 		void Update(float delta);
 		Sprite* const GetCurrentSprite() const
 		{
@@ -54,16 +63,18 @@ namespace engine
 			}
 			m_Handle = dl.Add(this);
 			m_Hitbox = new Hitbox(m_Pos, m_Dim, m_Vel, root);
+			m_Hitbox->SetTrigger(m_Trigger);
+			dl.m_Sweep.Add(m_Hitbox, m_Handle.list);
 			m_Added = true;
 		}
 	private:
 		Hitbox* m_Hitbox;
 		float m_Vertices[s_FloatsPerDynamic];
 		DynamicList::Handle m_Handle;
-		bool m_Added;
+		bool m_Added, m_Trigger;
 
 
 		void UpdateVertices();
-		void Init(QTNode* const root);
+		void Init(QTNode* const root, DynamicList& dl);
 	};
 }
@@ -4,12 +4,12 @@
 
 namespace engine
 {
-	const DynamicTemplate* const DynamicBank::Put(const std::string& name, const std::unordered_map<std::string, Script*>& scripts, const std::unordered_map<std::string, Sprite*>& states, const std::string& state, float speed)
+	const DynamicTemplate* const DynamicBank::Put(const std::string& name, const std::unordered_map<std::string, const ScriptProgram*>& scripts, const std::unordered_map<std::string, Sprite*>& states, const std::string& state, float speed, const math::CollisionFilter& filter, bool trigger)
 	{
 		const auto& it = m_Templates.find(name);
 		if (it != m_Templates.end())
 			printf("Overriding DynamicTemplate '%s'\n", name.c_str());
-		m_Templates[name] = { scripts, states, state, speed };
+		m_Templates[name] = { scripts, states, state, speed, filter, trigger };
 		return &m_Templates[name];
 	}
 	const DynamicTemplate* const DynamicBank::Get(const std::string& name) const
@@ -13,7 +13,7 @@ namespace engine
 		DynamicBank(DynamicBank&& other) = delete;
 
 
-		const DynamicTemplate* const Put(const std::string& name, const std::unordered_map<std::string, Script*>& scripts, const std::unordered_map<std::string, Sprite*>& states, const std::string& state, float speed);
+		const DynamicTemplate* const Put(const std::string& name, const std::unordered_map<std::string, const ScriptProgram*>& scripts, const std::unordered_map<std::string, Sprite*>& states, const std::string& state, float speed, const math::CollisionFilter& filter, bool trigger);
 		const DynamicTemplate* const Get(const std::string& name) const;
 	private:
 		std::unordered_map<std::string, DynamicTemplate> m_Templates;
@@ -4,13 +4,19 @@
 #include "graphics/Renderer.h"
 #include "DrawGroup.h"
 #include "script/Script.h"
+#include "world/Chunk.h"
 
 namespace engine
 {
 	DynamicList::DynamicList() :
 		IndexedList<Dynamic*, DynamicListHandle, Dynamic* const, Dynamic* const>(s_MaxDynamics, nullptr),
 		m_VertexArray(new gfx::VertexArray<GL_DYNAMIC_DRAW>(s_MaxDynamics* s_FloatsPerDynamic, { 2, 2, 1, 1 })),
-		m_DrawGroups(s_MaxDynamics / gfx::getMaxTextureUnits())
+		m_DrawGroups(s_MaxDynamics / gfx::getMaxTextureUnits()),
+		m_Sweep(s_MaxDynamics),
+		m_Pairs(s_MaxDynamics, s_PairCacheMargin),
+		m_Workers(s_ParallelCollisions ? math::min(s_CollisionThreads, math::max(std::thread::hardware_concurrency(), 1u)) : 1),
+		m_Collisions(m_Workers.GetThreadCount()),
+		m_CollisionRanges(s_ParallelCollisions ? s_MaxDynamics : 0)
 	{}
 	DynamicList::~DynamicList()
 	{
@@ -57,6 +63,8 @@ namespace engine
 		// add d->index to m_Openings
 		// clear relevant data in VA
 		auto& indices = d->m_Handle;
+		m_Sweep.Remove(indices.list);
+		m_Pairs.Remove(indices.list);
 		RemoveBase(indices.list);
 
 		DrawGroup* group = m_DrawGroups[indices.group];
@@ -65,13 +73,40 @@ namespace engine
 		if (group->IsEmpty())
 			m_DrawGroups.Remove(group->m_Index);
 	}
-	void DynamicList::Update(QTNode* const root, ScriptRuntime& rt)
+	void DynamicList::Update(QTNode* const root, const Chunk& chunk, ScriptRuntime& rt)
 	{
 		const float delta = rt.renderer->GetFrameDelta();
 		m_DrawGroups.ForEach([this, &rt](DrawGroup* g) { g->RunScripts(*this, rt); });
 		m_DrawGroups.ForEach([this, delta](DrawGroup* g) { g->Move(*this, delta); });
 		m_DrawGroups.ForEach([this, root](DrawGroup* g) { g->MoveHitboxes(*this, root); });
+		if constexpr (s_DynamicSweep)
+		{
+			m_Sweep.Update(delta);
+			m_Pairs.Update(m_Sweep, delta, [delta](QTNode::Element* const a, QTNode::Element* const b, auto* const ab, auto* const ba)
+				{
+					// each side resolves its own half of the collision, so both need their own contact
+					const bool hitA = a->Detect(b, delta, ab), hitB = b->Detect(a, delta, ba);
+					return hitA || hitB;
+				});
+		}
+		// Detection only reads Hitboxes and the static tiles, and resolving one Dynamic never moves another one, so everything can be found up front. Resolving can stop another one though, and those look again when it's their turn (see Dynamic::ResolveCollisions). Resolution still happens in the same order as it would otherwise, so the results are identical.
+		if constexpr (s_ParallelCollisions)
+		{
+			m_Workers.For(GetLast(), [this, delta](uint thread, uint begin, uint end)
+				{
+					m_Collisions[thread].clear();
+					for (uint i = begin; i < end; i++)
+						if (IsValid(i))
+							m_List[i]->FindCollisions(delta, *this, thread);
+				});
+		}
 		m_DrawGroups.ForEach([this, delta](DrawGroup* g) { g->ResolveCollisions(*this, delta); });
+		root->EndFrame();
+		// Only once everything is where it's going to end up this frame. Without any Triggers, something that was still in one (or just left one) needs one more Update to exit it (or clear its events).
+		const bool triggers = chunk.HasTriggers();
+		for (uint i = 0; i < GetLast(); i++)
+			if (IsValid(i) && (triggers || !m_List[i]->GetTriggers().IsIdle()))
+				m_List[i]->UpdateTriggers(chunk, delta, m_TriggerScratch);
 		/*m_DrawGroups.ForEach([this, delta](DrawGroup* g) { g->Move(*this, delta); });*/
 	}
 	void DynamicList::Draw(Renderer& renderer)
@@ -6,6 +6,7 @@ namespace engine
 {
 	class Dynamic;
 	class Renderer;
+	class Chunk;
 	struct ScriptRuntime;
 
 	struct DynamicListHandle
@@ -17,7 +18,10 @@ namespace engine
 	{
 	public:
 		constexpr static uint s_MaxDynamics = 1024;
+		// see s_CollisionThreads
+		constexpr static bool s_ParallelCollisions = s_DynamicSweep && s_CollisionThreads > 1;
 		friend class DrawGroup;
+		friend class Dynamic;
 
 
 		DynamicList();
@@ -30,9 +34,30 @@ namespace engine
 		void Remove(Dynamic* const d) override;
 		void Draw(Renderer& renderer);
 		void Update(uint i);
-		void Update(QTNode* const root, ScriptRuntime& rt);
+		void Update(QTNode* const root, const Chunk& chunk, ScriptRuntime& rt);
+		// Pairs of Dynamics (by list index) that started touching, kept touching, or stopped touching during the last Update. Only filled in with s_DynamicSweep.
+		const std::vector<math::PairCache<QTNode::Element>::Event>& GetCollisionEvents() const
+		{
+			return m_Pairs.GetEvents();
+		}
 	private:
 		gfx::VertexArray<GL_DYNAMIC_DRAW>* m_VertexArray;
 		DrawGroupList m_DrawGroups;
+		// dynamic Hitboxes by list index, see s_DynamicSweep
+		math::SortAndSweep<QTNode::Element> m_Sweep;
+		// m_Sweep's pairs from frame to frame, and the contacts that each Dynamic resolves
+		math::PairCache<QTNode::Element> m_Pairs;
+		// Where each Dynamic's collisions are (by list index) in the per-thread lists below. Only used with s_ParallelCollisions.
+		struct CollisionRange
+		{
+			uint thread, start, count;
+			// velocity of the Dynamic's Hitbox when they were found
+			math::Vec2<float> vel;
+		};
+		math::ThreadPool m_Workers;
+		std::vector<std::vector<QTNode::Element::CollisionInfo>> m_Collisions;
+		std::vector<CollisionRange> m_CollisionRanges;
+		// reused by Dynamic::UpdateTriggers
+		std::vector<uint> m_TriggerScratch;
 	};
 }